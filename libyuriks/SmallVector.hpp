@@ -0,0 +1,199 @@
+#pragma once
+#include "noexcept.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/** Vector with room for N elements inside the object itself. It only
+ * allocates from the heap once it grows past that. */
+template <typename T, size_t N>
+struct SmallVector {
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+
+	SmallVector()
+		: data_begin(inline_data()), count(0), cap(N)
+	{}
+
+	SmallVector(const SmallVector& o)
+		: data_begin(inline_data()), count(0), cap(N)
+	{
+		*this = o;
+	}
+
+	// Moves must not throw, or std::vector copies its elements when growing
+	// instead of moving them. Moving T itself is assumed not to throw.
+	SmallVector(SmallVector&& o) YKS_NOEXCEPT
+		: data_begin(inline_data()), count(0), cap(N)
+	{
+		*this = std::move(o);
+	}
+
+	~SmallVector() {
+		clear();
+		free_heap();
+	}
+
+	SmallVector& operator=(const SmallVector& o) {
+		if (this == &o)
+			return *this;
+
+		clear();
+		reserve(o.count);
+		std::uninitialized_copy(o.begin(), o.end(), data_begin);
+		count = o.count;
+		return *this;
+	}
+
+	SmallVector& operator=(SmallVector&& o) YKS_NOEXCEPT {
+		if (this == &o)
+			return *this;
+
+		clear();
+		if (!o.is_inline()) {
+			// Steal the heap buffer
+			free_heap();
+			data_begin = o.data_begin;
+			cap = o.cap;
+			count = o.count;
+			o.data_begin = o.inline_data();
+			o.cap = N;
+			o.count = 0;
+		} else {
+			reserve(o.count);
+			for (size_t i = 0; i < o.count; ++i) {
+				new (data_begin + i) T(std::move(o.data_begin[i]));
+			}
+			count = o.count;
+			o.clear();
+		}
+		return *this;
+	}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	size_t capacity() const { return cap; }
+	/** True while the elements still live in the inline buffer. */
+	bool is_inline() const { return static_cast<const void*>(data_begin) == static_cast<const void*>(&inline_storage); }
+
+	iterator begin() { return data_begin; }
+	iterator end() { return data_begin + count; }
+	const_iterator begin() const { return data_begin; }
+	const_iterator end() const { return data_begin + count; }
+	const_iterator cbegin() const { return data_begin; }
+	const_iterator cend() const { return data_begin + count; }
+
+	T* data() { return data_begin; }
+	const T* data() const { return data_begin; }
+
+	T& operator[](size_t i) { assert(i < count); return data_begin[i]; }
+	const T& operator[](size_t i) const { assert(i < count); return data_begin[i]; }
+	T& back() { return data_begin[count - 1]; }
+	const T& back() const { return data_begin[count - 1]; }
+
+	void reserve(size_t n) {
+		if (n <= cap)
+			return;
+
+		T* new_data = static_cast<T*>(::operator new(n * sizeof(T)));
+		for (size_t i = 0; i < count; ++i) {
+			new (new_data + i) T(std::move(data_begin[i]));
+			data_begin[i].~T();
+		}
+		free_heap();
+		data_begin = new_data;
+		cap = n;
+	}
+
+	void push_back(const T& val) {
+		insert(end(), val);
+	}
+
+	void pop_back() {
+		assert(count > 0);
+		data_begin[--count].~T();
+	}
+
+	iterator insert(const_iterator pos, const T& val) {
+		const size_t i = pos - data_begin;
+		assert(i <= count);
+		if (count == cap) {
+			T copy(val); // val might live in this vector
+			reserve(cap * 2);
+			return insert_at(i, std::move(copy));
+		}
+		return insert_at(i, T(val));
+	}
+
+	iterator insert(const_iterator pos, T&& val) {
+		const size_t i = pos - data_begin;
+		assert(i <= count);
+		if (count == cap) {
+			T moved(std::move(val)); // val might live in this vector
+			reserve(cap * 2);
+			return insert_at(i, std::move(moved));
+		}
+		return insert_at(i, std::move(val));
+	}
+
+	iterator erase(const_iterator pos) {
+		const size_t i = pos - data_begin;
+		assert(i < count);
+		std::move(data_begin + i + 1, data_begin + count, data_begin + i);
+		pop_back();
+		return data_begin + i;
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		const size_t i = first - data_begin;
+		const size_t n = last - first;
+		std::move(data_begin + i + n, data_begin + count, data_begin + i);
+		for (size_t k = 0; k < n; ++k) {
+			pop_back();
+		}
+		return data_begin + i;
+	}
+
+	void clear() {
+		while (count > 0) {
+			pop_back();
+		}
+	}
+
+private:
+	typename std::aligned_storage<sizeof(T) * N, std::alignment_of<T>::value>::type inline_storage;
+	T* data_begin;
+	size_t count;
+	size_t cap;
+
+	T* inline_data() { return static_cast<T*>(static_cast<void*>(&inline_storage)); }
+
+	void free_heap() {
+		if (!is_inline()) {
+			::operator delete(data_begin);
+		}
+		data_begin = inline_data();
+		cap = N;
+	}
+
+	iterator insert_at(size_t i, T&& val) {
+		if (i == count) {
+			new (data_begin + count) T(std::move(val));
+		} else {
+			new (data_begin + count) T(std::move(data_begin[count - 1]));
+			std::move_backward(data_begin + i, data_begin + count - 1, data_begin + count);
+			data_begin[i] = std::move(val);
+		}
+		++count;
+		return data_begin + i;
+	}
+};
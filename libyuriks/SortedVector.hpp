@@ -1,5 +1,8 @@
 #pragma once
+#include "memory/MemoryResource.hpp"
+#include "memory/MemoryStats.hpp"
 #include <algorithm>
+#include <iterator>
 #include <tuple>
 #include <vector>
 
@@ -13,37 +16,110 @@ struct TupleKey {
 };
 
 /** A wrapper around std::vector with functions to insert items keeping the
- * vector in sorted order, as well as looking up and removing items by key. */
-template <typename T, typename KeyPred = TupleKey<T>>
+ * vector in sorted order, as well as looking up and removing items by key.
+ * StorageT can be swapped for e.g. SmallVector to keep short lists inline. */
+template <typename T, typename KeyPred = TupleKey<T>, typename StorageT = std::vector<T>>
 struct SortedVector {
-	typedef std::vector<T> Storage;
+	typedef StorageT Storage;
 	typedef typename Storage::iterator iterator;
 	typedef typename Storage::const_iterator const_iterator;
 
 	typedef typename KeyPred::Key K;
 
+	// Lists up to this size are searched linearly, which beats binary search
+	// for the handful of elements that fit in a cache line or two.
+	static const size_t linear_search_threshold = 16;
+
 	Storage data;
 
+	SortedVector() {}
+
+	/** Allocates from resource. Needs a Storage that takes an allocator, like yks::ResourceVector<T>. */
+	explicit SortedVector(yks::MemoryResource* resource)
+		: data(resource)
+	{}
+
 	iterator insert(const T& val) {
+		return data.insert(lower_bound(KeyPred::get(val)), val);
+	}
+
+	/** Inserts all of [first, last). The batch is sorted and then merged into
+	 * the vector from the back, so this is O(n + k log k) instead of O(n * k)
+	 * for k separate inserts. */
+	template <typename It>
+	void insert_range(It first, It last) {
+		std::vector<T> batch(first, last);
+		if (batch.empty())
+			return;
+
+		std::stable_sort(batch.begin(), batch.end(), [](const T& a, const T& b) { return KeyPred::get(a) < KeyPred::get(b); });
+
+		const size_t old_size = data.size();
+		data.reserve(old_size + batch.size());
+		for (const T& v : batch) {
+			data.push_back(v); // Placeholders, overwritten by the merge below
+		}
+
 		using std::begin;
-		using std::end;
+		auto data_begin = begin(data);
+		size_t out = data.size();
+		size_t i = old_size;
+		size_t j = batch.size();
+		while (j > 0) {
+			if (i > 0 && KeyPred::get(batch[j - 1]) < KeyPred::get(data_begin[i - 1])) {
+				data_begin[--out] = std::move(data_begin[--i]);
+			} else {
+				data_begin[--out] = std::move(batch[--j]);
+			}
+		}
+	}
+
+	/** Inserts val, using hint as the position if it keeps the vector sorted.
+	 * Appending in key order with hint = end() is O(1) per element. */
+	template <typename... Args>
+	iterator emplace_hint(const_iterator hint, Args&&... params) {
+		T val(std::forward<Args>(params)...);
+		const K& key = KeyPred::get(val);
 
-		auto insert_pos = std::lower_bound(begin(data), end(data), val);
-		return data.insert(insert_pos, val);
+		const_iterator data_begin = data.begin();
+		const_iterator data_end = data.end();
+		if ((hint != data_begin && key < KeyPred::get(*(hint - 1))) || (hint != data_end && KeyPred::get(*hint) < key)) {
+			hint = lower_bound(key);
+		}
+		return data.insert(hint, std::move(val));
 	}
 
 	iterator lookup(const K& key) {
-		using std::begin;
 		using std::end;
 
 		auto data_end = end(data);
-		auto pos = std::lower_bound(begin(data), data_end, key, [](const T& v, const K& k) { return KeyPred::get(v) < k; });
+		auto pos = lower_bound(key);
 		if (pos != data_end && KeyPred::get(*pos) == key) {
 			return pos;
 		}
 		return data_end;
 	}
 
+	/** Returns the first element with a key not less than key. */
+	iterator lower_bound(const K& key) {
+		using std::begin;
+		using std::end;
+
+		auto data_begin = begin(data);
+		auto data_end = end(data);
+		if (size_t(data_end - data_begin) <= linear_search_threshold) {
+			while (data_begin != data_end && KeyPred::get(*data_begin) < key) {
+				++data_begin;
+			}
+			return data_begin;
+		}
+		return std::lower_bound(data_begin, data_end, key, [](const T& v, const K& k) { return KeyPred::get(v) < k; });
+	}
+
+	yks::MemoryUsage getMemoryUsage() const {
+		return yks::MemoryUsage(data.size(), data.capacity(), data.capacity() * sizeof(T));
+	}
+
 	bool remove(const K& key) {
 		using std::end;
 
@@ -54,4 +130,32 @@ struct SortedVector {
 		}
 		return false;
 	}
+
+	/** Removes every element whose key is in keys, which must be sorted.
+	 * Done in a single compaction pass. Returns the number of elements removed. */
+	size_t remove_keys(const K* keys, size_t num_keys) {
+		using std::begin;
+		using std::end;
+
+		auto data_end = end(data);
+		auto out = begin(data);
+		const K* keys_end = keys + num_keys;
+		for (auto in = begin(data); in != data_end; ++in) {
+			const K& key = KeyPred::get(*in);
+			while (keys != keys_end && *keys < key) {
+				++keys;
+			}
+			if (keys != keys_end && *keys == key)
+				continue;
+
+			if (out != in) {
+				*out = std::move(*in);
+			}
+			++out;
+		}
+
+		const size_t removed = data_end - out;
+		data.erase(out, data_end);
+		return removed;
+	}
 };
@@ -0,0 +1,112 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#define YKS_THREAD_LOCAL __declspec(thread)
+#else
+#define YKS_THREAD_LOCAL thread_local
+#endif
+
+namespace yks {
+
+	// Set on threads while they run a job, so nested dispatches run serially
+	// instead of waiting on workers that may be the ones dispatching.
+	static YKS_THREAD_LOCAL bool inside_job = false;
+
+	ThreadPool::ThreadPool(size_t num_threads)
+		: job(nullptr), job_count(0), next_index(0), active_workers(0), job_generation(0), quitting(false)
+	{
+		if (num_threads == 0) {
+			num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+
+		workers.reserve(num_threads - 1);
+		for (size_t i = 1; i < num_threads; ++i) {
+			workers.emplace_back([this]() { worker_main(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quitting = true;
+		}
+		work_ready.notify_all();
+
+		for (auto& t : workers) {
+			t.join();
+		}
+	}
+
+	void ThreadPool::run(size_t count, const std::function<void(size_t)>& fn) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (inside_job || job != nullptr || workers.empty()) {
+				lock.unlock();
+				run_serially(count, fn);
+				return;
+			}
+			job = &fn;
+			job_count = count;
+			next_index.store(0, std::memory_order_relaxed);
+			active_workers = workers.size();
+			++job_generation;
+		}
+		work_ready.notify_all();
+
+		work();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		work_done.wait(lock, [this]() { return active_workers == 0; });
+		job = nullptr;
+	}
+
+	void ThreadPool::worker_main() {
+		uint64_t seen_generation = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			work_ready.wait(lock, [&]() { return quitting || job_generation != seen_generation; });
+			if (quitting)
+				return;
+			seen_generation = job_generation;
+
+			lock.unlock();
+			work();
+			lock.lock();
+
+			if (--active_workers == 0) {
+				work_done.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::work() {
+		inside_job = true;
+		for (;;) {
+			const size_t i = next_index.fetch_add(1, std::memory_order_relaxed);
+			if (i >= job_count)
+				break;
+			(*job)(i);
+		}
+		inside_job = false;
+	}
+
+	void ThreadPool::run_serially(size_t count, const std::function<void(size_t)>& fn) {
+		const bool was_inside_job = inside_job;
+		inside_job = true;
+		for (size_t i = 0; i < count; ++i) {
+			fn(i);
+		}
+		inside_job = was_inside_job;
+	}
+
+	bool ThreadPool::isInsideJob() {
+		return inside_job;
+	}
+
+	ThreadPool& ThreadPool::getDefault() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+}
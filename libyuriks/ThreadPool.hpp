@@ -0,0 +1,60 @@
+#pragma once
+#include "noncopyable.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yks {
+
+	/** Fixed set of worker threads that are kept around between jobs, for
+	 * work that is dispatched too often to spawn threads for each time. */
+	struct ThreadPool {
+		/** With num_threads = 0, uses one thread per hardware thread. The
+		 * thread calling run() is counted as one of them. */
+		explicit ThreadPool(size_t num_threads = 0);
+		~ThreadPool();
+
+		/** Calls fn(i) for each i in [0, count), spread across the workers
+		 * and the calling thread. Returns once all calls are done. If the
+		 * calling thread is already running a job of any pool, or this pool
+		 * is busy with another thread's job, the calls run serially instead. */
+		void run(size_t count, const std::function<void(size_t)>& fn);
+
+		/** True while the calling thread is running a job for some pool. */
+		static bool isInsideJob();
+
+		/** Pool shared by helpers like parallel_for, with one thread per
+		 * hardware thread. Created on first use. */
+		static ThreadPool& getDefault();
+
+		size_t numThreads() const {
+			return workers.size() + 1;
+		}
+
+	private:
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable work_ready;
+		std::condition_variable work_done;
+
+		// Current job. Only changed while no worker is active.
+		const std::function<void(size_t)>* job;
+		size_t job_count;
+		std::atomic<size_t> next_index;
+		size_t active_workers;
+		uint64_t job_generation;
+		bool quitting;
+
+		void worker_main();
+		void work();
+		static void run_serially(size_t count, const std::function<void(size_t)>& fn);
+
+		NONCOPYABLE(ThreadPool);
+	};
+
+}
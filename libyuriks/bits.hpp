@@ -0,0 +1,26 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace yks {
+
+	/** Index of the lowest set bit. x must not be zero. */
+	inline unsigned int countTrailingZeros(uint64_t x) {
+		assert(x != 0);
+#ifdef _MSC_VER
+		unsigned long i;
+		if (_BitScanForward(&i, static_cast<uint32_t>(x))) {
+			return i;
+		}
+		_BitScanForward(&i, static_cast<uint32_t>(x >> 32));
+		return i + 32;
+#else
+		return __builtin_ctzll(x);
+#endif
+	}
+
+}
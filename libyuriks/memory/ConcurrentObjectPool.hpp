@@ -0,0 +1,162 @@
+#pragma once
+#include "Handle.hpp"
+#include "noncopyable.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace yks {
+
+	/** Fixed-capacity pool which can be inserted into and removed from by
+	 * several threads at once without locking. Objects are constructed in
+	 * place and never move.
+	 *
+	 * Slot generations are odd while a slot is in use and even while it's
+	 * free. Free slots form a stack whose head is tagged with a counter to
+	 * avoid ABA problems. */
+	template <typename T>
+	struct ConcurrentObjectPool {
+		static const uint32_t null_index = UINT32_MAX;
+
+		explicit ConcurrentObjectPool(size_t capacity)
+			: slots(new Slot[capacity]), slot_capacity(capacity)
+		{
+			assert(capacity < null_index);
+			free_head.store(pack(0, null_index), std::memory_order_relaxed);
+			high_water.store(0, std::memory_order_relaxed);
+		}
+
+		~ConcurrentObjectPool() {
+			for_each([](Handle, T& obj) { obj.~T(); });
+		}
+
+		/** Returns a null handle if the pool is full. Thread-safe. */
+		template <typename... Args>
+		Handle emplace(Args&&... params) {
+			const uint32_t i = allocate_slot();
+			if (i == null_index)
+				return Handle();
+
+			Slot& slot = slots[i];
+			new (&slot.storage) T(std::forward<Args>(params)...);
+			const uint32_t gen = slot.generation.load(std::memory_order_relaxed) + 1;
+			slot.generation.store(gen, std::memory_order_release);
+			return Handle(i, gen);
+		}
+
+		/** Thread-safe. If several threads remove the same handle only one does it. */
+		void remove(const Handle h) {
+			if (h.index >= slot_capacity)
+				return;
+
+			Slot& slot = slots[h.index];
+			uint32_t gen = h.generation;
+			if (!(gen & 1) || !slot.generation.compare_exchange_strong(gen, gen + 1, std::memory_order_acq_rel))
+				return;
+
+			object(slot)->~T();
+			free_slot(static_cast<uint32_t>(h.index));
+		}
+
+		T* operator[] (const Handle h) {
+			return isValid(h) ? object(slots[h.index]) : nullptr;
+		}
+
+		const T* operator[] (const Handle h) const {
+			return isValid(h) ? object(slots[h.index]) : nullptr;
+		}
+
+		/** Checks if object referenced by handle is still in the pool. */
+		bool isValid(const Handle h) const {
+			return h.index < slot_capacity && (h.generation & 1)
+				&& slots[h.index].generation.load(std::memory_order_acquire) == h.generation;
+		}
+
+		size_t capacity() const {
+			return slot_capacity;
+		}
+
+		/** Calls fn(handle, object) for every live object. Freed slots are
+		 * reused first, so live objects stay packed at the start of the pool.
+		 * Not safe to call while other threads are modifying the pool. */
+		template <typename Fn>
+		void for_each(const Fn& fn) {
+			const uint32_t end = std::min<uint32_t>(high_water.load(std::memory_order_acquire), static_cast<uint32_t>(slot_capacity));
+			for (uint32_t i = 0; i < end; ++i) {
+				const uint32_t gen = slots[i].generation.load(std::memory_order_relaxed);
+				if (gen & 1) {
+					fn(Handle(i, gen), *object(slots[i]));
+				}
+			}
+		}
+
+	private:
+		struct Slot {
+			std::atomic<uint32_t> generation;
+			std::atomic<uint32_t> next_free;
+			typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+
+			Slot() {
+				generation.store(0, std::memory_order_relaxed);
+				next_free.store(null_index, std::memory_order_relaxed);
+			}
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		size_t slot_capacity;
+
+		// Low 32 bits: index of first free slot. High 32 bits: ABA tag.
+		std::atomic<uint64_t> free_head;
+		// Slots at or past this have never been used.
+		std::atomic<uint32_t> high_water;
+
+		static uint64_t pack(uint32_t tag, uint32_t index) {
+			return (uint64_t(tag) << 32) | index;
+		}
+
+		static T* object(Slot& slot) {
+			return static_cast<T*>(static_cast<void*>(&slot.storage));
+		}
+
+		static const T* object(const Slot& slot) {
+			return static_cast<const T*>(static_cast<const void*>(&slot.storage));
+		}
+
+		uint32_t allocate_slot() {
+			// Pop head off of free list
+			uint64_t head = free_head.load(std::memory_order_acquire);
+			for (;;) {
+				const uint32_t index = static_cast<uint32_t>(head);
+				if (index == null_index)
+					break;
+
+				const uint32_t next = slots[index].next_free.load(std::memory_order_relaxed);
+				if (free_head.compare_exchange_weak(head, pack(static_cast<uint32_t>(head >> 32) + 1, next), std::memory_order_acq_rel))
+					return index;
+			}
+
+			// Free list is empty, take a fresh slot
+			const uint32_t index = high_water.fetch_add(1, std::memory_order_relaxed);
+			if (index >= slot_capacity) {
+				high_water.fetch_sub(1, std::memory_order_relaxed);
+				return null_index;
+			}
+			return index;
+		}
+
+		void free_slot(uint32_t index) {
+			uint64_t head = free_head.load(std::memory_order_relaxed);
+			do {
+				slots[index].next_free.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+			} while (!free_head.compare_exchange_weak(head, pack(static_cast<uint32_t>(head >> 32) + 1, index), std::memory_order_acq_rel));
+		}
+
+		NONCOPYABLE(ConcurrentObjectPool);
+	};
+
+}
@@ -2,29 +2,44 @@
 
 namespace yks {
 
-	DynamicPool::DynamicPool(size_t object_size)
-		: pool(object_size)
+	DynamicPool::DynamicPool(size_t object_size, size_t alignment, const ObjectOps& ops)
+		: pool(object_size, alignment, ops)
 	{}
 
 	std::tuple<Handle, void*> DynamicPool::insert(const void* object) {
+		return insert_at_end(const_cast<void*>(object), false);
+	}
+
+	std::tuple<Handle, void*> DynamicPool::insertMoved(void* object) {
+		assert(object != nullptr);
+		return insert_at_end(object, true);
+	}
+
+	std::tuple<Handle, void*> DynamicPool::insert_at_end(void* object, bool move) {
 		// Expand roster if we're out of entries
 		if (first_free_index >= roster.size()) {
 			expand_roster();
 		}
 
-		// Pop head off of free list
-		const size_t roster_index = first_free_index;
-		first_free_index = roster[roster_index].index;
-
-		// Point roster entry to right place and insert object
-		roster[roster_index].index = pool.size();
+		// Insert object first, so the roster is left alone if that throws
+		const size_t old_capacity = pool.capacity();
 		void* inserted_ptr;
-		if (object != nullptr) {
-			inserted_ptr = pool.push_back(object);
-		} else {
+		if (object == nullptr) {
 			inserted_ptr = pool.push_back();
+		} else if (move) {
+			inserted_ptr = pool.push_back_move(object);
+		} else {
+			inserted_ptr = pool.push_back(static_cast<const void*>(object));
 		}
+
+		// Pop head off of free list and point it to the object
+		const size_t roster_index = first_free_index;
+		first_free_index = roster[roster_index].index;
+		roster[roster_index].index = pool.size() - 1;
 		pool_indices.push_back(roster_index);
+		if (pool.capacity() > old_capacity) {
+			++growth_events;
+		}
 
 		return std::make_tuple(Handle(roster_index, roster[roster_index].generation), inserted_ptr);
 	}
@@ -45,7 +60,7 @@ namespace yks {
 		// Move last element in place of the removed one, updating roster
 		if (pool_index != moved_pool_index) {
 			roster[moved_roster_index].index = pool_index;
-			pool.copy(moved_pool_index, pool_index);
+			pool.move(moved_pool_index, pool_index);
 			pool_indices[pool_index] = pool_indices[moved_pool_index];
 		}
 		pool.pop_back();
@@ -85,7 +100,7 @@ namespace yks {
 		if (index >= pool.size())
 			return Handle();
 		else
-			return Handle(index, roster[pool_indices[index]].generation);
+			return Handle(pool_indices[index], roster[pool_indices[index]].generation);
 	}
 
 	/** Get index into pool for handle. */
@@ -97,6 +112,11 @@ namespace yks {
 		}
 	}
 
+	MemoryUsage DynamicPool::getMemoryUsage() const {
+		return MemoryUsage(pool.size(), pool.capacity(),
+			roster.capacity() * sizeof(Handle) + pool.bytes() + pool_indices.capacity() * sizeof(size_t), growth_events);
+	}
+
 	void DynamicPool::expand_roster() {
 		const Handle new_entry(first_free_index, 0);
 
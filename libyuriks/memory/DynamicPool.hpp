@@ -1,5 +1,6 @@
 #pragma once
 #include "DynamicPoolAllocator.hpp"
+#include "MemoryStats.hpp"
 #include "Handle.hpp"
 #include <cassert>
 #include <cstddef>
@@ -19,9 +20,15 @@ namespace yks {
 		DynamicPoolAllocator pool;
 		std::vector<size_t> pool_indices;
 
-		DynamicPool(size_t object_size);
+		size_t growth_events = 0; // Times pool's capacity grew, for MemoryUsage
 
+		DynamicPool(size_t object_size, size_t alignment = DynamicPoolAllocator::default_alignment, const ObjectOps& ops = ObjectOps());
+
+		/** Copies object into the pool. If object is null, the returned storage
+		 * is left uninitialized and the caller must construct the object in it. */
 		std::tuple<Handle, void*> insert(const void* object);
+		/** Moves object into the pool, leaving it moved-from. Works for move-only types. */
+		std::tuple<Handle, void*> insertMoved(void* object);
 		void remove(const Handle h);
 
 		void* operator[] (const Handle h);
@@ -36,7 +43,10 @@ namespace yks {
 		/** Get index into pool for handle. */
 		size_t getPoolIndex(const Handle h) const;
 
+		MemoryUsage getMemoryUsage() const;
+
 	private:
+		std::tuple<Handle, void*> insert_at_end(void* object, bool move);
 		void expand_roster();
 	};
 
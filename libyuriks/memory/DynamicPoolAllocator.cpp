@@ -1,33 +1,90 @@
 #include "DynamicPoolAllocator.hpp"
+#include "VirtualMemory.hpp"
+#include <algorithm>
 #include <cstring>
+#include <cstdlib>
 #include <cassert>
+#include <new>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
 
 namespace yks {
 
-	DynamicPoolAllocator::DynamicPoolAllocator(size_t object_size)
-		: object_size(object_size),
+	static uint8_t* alignedAlloc(size_t bytes, size_t alignment) {
+#ifdef _MSC_VER
+		return static_cast<uint8_t*>(_aligned_malloc(bytes, alignment));
+#else
+		void* p = nullptr;
+		if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, bytes) != 0) {
+			return nullptr;
+		}
+		return static_cast<uint8_t*>(p);
+#endif
+	}
+
+	static void alignedFree(uint8_t* p) {
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+
+	DynamicPoolAllocator::DynamicPoolAllocator(size_t object_size, size_t alignment, const ObjectOps& ops)
+		: object_size(object_size), alignment(alignment),
+		stride((object_size + alignment - 1) / alignment * alignment), ops(ops),
 		data_begin(nullptr), data_end(nullptr),
-		data_alloc_end(nullptr)
-	{}
+		data_alloc_end(nullptr), reserved_bytes(0)
+	{
+		assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	}
 
 	DynamicPoolAllocator::DynamicPoolAllocator(const DynamicPoolAllocator& o)
-		: object_size(o.object_size),
+		: object_size(o.object_size), alignment(o.alignment),
+		stride(o.stride), ops(o.ops),
 		data_begin(nullptr), data_end(nullptr),
-		data_alloc_end(nullptr)
+		data_alloc_end(nullptr), reserved_bytes(0)
 	{
 		*this = o;
 	}
 
 	DynamicPoolAllocator::~DynamicPoolAllocator() {
-		delete[] data_begin;
+		destroy_all();
+		free_storage();
 	}
 
 	DynamicPoolAllocator& DynamicPoolAllocator::operator =(const DynamicPoolAllocator& o) {
-		delete[] data_begin;
-		data_begin = new uint8_t[o.data_alloc_end - o.data_begin];
-		data_end = data_begin + (o.data_end - o.data_begin);
-		data_alloc_end = data_begin + (o.data_alloc_end - o.data_begin);
-		std::memcpy(data_begin, o.data_begin, o.data_end - o.data_begin);
+		if (this == &o)
+			return *this;
+		// A bitwise copy of e.g. a unique_ptr would free its object twice
+		if (!o.ops.isCopyable())
+			throw std::logic_error("DynamicPoolAllocator: copying a pool of a type that isn't copyable");
+
+		destroy_all();
+		free_storage();
+
+		object_size = o.object_size;
+		alignment = o.alignment;
+		stride = o.stride;
+		ops = o.ops;
+
+		const size_t alloc_bytes = o.data_alloc_end - o.data_begin;
+		data_begin = alloc_bytes != 0 ? alignedAlloc(alloc_bytes, alignment) : nullptr;
+		data_end = data_begin;
+		data_alloc_end = data_begin + alloc_bytes;
+
+		if (ops.copy_construct == nullptr) {
+			std::memcpy(data_begin, o.data_begin, o.data_end - o.data_begin);
+			data_end = data_begin + (o.data_end - o.data_begin);
+		} else {
+			for (const uint8_t* src = o.data_begin; src != o.data_end; src += stride) {
+				ops.copy_construct(data_end, src);
+				data_end += stride;
+			}
+		}
 
 		return *this;
 	}
@@ -36,72 +93,168 @@ namespace yks {
 		return object_size;
 	}
 
+	size_t DynamicPoolAllocator::getAlignment() const {
+		return alignment;
+	}
+
 	size_t DynamicPoolAllocator::size() const {
-		return (data_end - data_begin) / object_size;
+		return (data_end - data_begin) / stride;
 	}
 
 	size_t DynamicPoolAllocator::capacity() const {
-		return (data_alloc_end - data_begin) / object_size;
+		return (data_alloc_end - data_begin) / stride;
+	}
+
+	size_t DynamicPoolAllocator::bytes() const {
+		return data_alloc_end - data_begin;
+	}
+
+	void DynamicPoolAllocator::reserveVirtual(size_t max_objects) {
+		assert(data_end == data_begin);
+		free_storage();
+
+		const size_t bytes = roundUpToCommitGranularity(max_objects * stride);
+		data_begin = static_cast<uint8_t*>(reserveAddressSpace(bytes));
+		if (data_begin == nullptr)
+			throw std::bad_alloc();
+		reserved_bytes = bytes;
+		data_end = data_alloc_end = data_begin;
+	}
+
+	void DynamicPoolAllocator::free_storage() {
+		if (reserved_bytes != 0) {
+			releaseAddressSpace(data_begin, reserved_bytes);
+			reserved_bytes = 0;
+		} else {
+			alignedFree(data_begin);
+		}
+		data_begin = data_end = data_alloc_end = nullptr;
 	}
 
 	void DynamicPoolAllocator::reserve(size_t num) {
-		if (num * object_size < (size_t)(data_alloc_end - data_begin)) {
-			expand(num * object_size);
+		if (reserved_bytes != 0 && num * stride > reserved_bytes)
+			throw std::bad_alloc();
+		if (num * stride > (size_t)(data_alloc_end - data_begin)) {
+			expand(num * stride);
 		}
 	}
 
 	void* DynamicPoolAllocator::push_back() {
-		if (data_end == data_alloc_end) {
+		if ((size_t)(data_alloc_end - data_end) < stride) {
 			expand();
 		}
 
 		void* dst_ptr = data_end;
-		data_end += object_size;
+		data_end += stride;
 		std::memset(dst_ptr, 0x55, object_size);
 		return dst_ptr;
 	}
 
 	void* DynamicPoolAllocator::push_back(const void* src_data) {
-		if (data_end == data_alloc_end) {
+		if (!ops.isCopyable())
+			throw std::logic_error("DynamicPoolAllocator: copying an object of a type that isn't copyable");
+		if ((size_t)(data_alloc_end - data_end) < stride) {
+			expand();
+		}
+
+		void* dst_ptr = data_end;
+		if (ops.copy_construct != nullptr) {
+			ops.copy_construct(dst_ptr, src_data);
+		} else {
+			std::memcpy(dst_ptr, src_data, object_size);
+		}
+		data_end += stride;
+		return dst_ptr;
+	}
+
+	void* DynamicPoolAllocator::push_back_move(void* src_data) {
+		if ((size_t)(data_alloc_end - data_end) < stride) {
 			expand();
 		}
 
 		void* dst_ptr = data_end;
-		data_end += object_size;
-		std::memcpy(dst_ptr, src_data, object_size);
+		if (ops.move_construct != nullptr) {
+			ops.move_construct(dst_ptr, src_data);
+		} else {
+			std::memcpy(dst_ptr, src_data, object_size);
+		}
+		data_end += stride;
 		return dst_ptr;
 	}
 
 	void DynamicPoolAllocator::pop_back() {
 		assert(data_end != data_begin);
-		data_end -= object_size;
+		data_end -= stride;
+		if (ops.destroy != nullptr) {
+			ops.destroy(data_end);
+		}
 	}
 
-	void DynamicPoolAllocator::copy(size_t from, size_t to) {
-		if (from != to) {
-			std::memcpy(data_begin + from * object_size, data_begin + to * object_size, object_size);
+	void DynamicPoolAllocator::move(size_t from, size_t to) {
+		if (from == to)
+			return;
+
+		uint8_t* src = data_begin + from * stride;
+		uint8_t* dst = data_begin + to * stride;
+		if (ops.destroy != nullptr) {
+			ops.destroy(dst);
+		}
+		if (ops.move_construct != nullptr) {
+			ops.move_construct(dst, src);
+		} else {
+			std::memcpy(dst, src, object_size);
 		}
 	}
 
 	void* DynamicPoolAllocator::operator [](size_t i) {
-		uint8_t* p = data_begin + i*object_size;
+		uint8_t* p = data_begin + i*stride;
 		assert(p < data_end);
 		return p;
 	}
 
 	const void* DynamicPoolAllocator::operator [](size_t i) const {
-		const uint8_t* p = data_begin + i*object_size;
+		const uint8_t* p = data_begin + i*stride;
 		assert(p < data_end);
 		return p;
 	}
 
+	void DynamicPoolAllocator::destroy_all() {
+		if (ops.destroy != nullptr) {
+			for (uint8_t* p = data_begin; p != data_end; p += stride) {
+				ops.destroy(p);
+			}
+		}
+	}
+
 	void DynamicPoolAllocator::expand(size_t new_capacity_bytes) {
 		assert(new_capacity_bytes > (size_t)(data_alloc_end - data_begin));
-		uint8_t* new_begin = new uint8_t[new_capacity_bytes];
+
+		if (reserved_bytes != 0) {
+			// Grow in place by committing more of the reserved range. It's
+			// committed in whole pages, so the end can fall inside an object.
+			const size_t committed = data_alloc_end - data_begin;
+			new_capacity_bytes = std::min(roundUpToCommitGranularity(new_capacity_bytes), reserved_bytes);
+			if (new_capacity_bytes < (size_t)(data_end - data_begin) + stride || !commitMemory(data_alloc_end, new_capacity_bytes - committed))
+				throw std::bad_alloc();
+			data_alloc_end = data_begin + new_capacity_bytes;
+			return;
+		}
+
+		uint8_t* new_begin = alignedAlloc(new_capacity_bytes, alignment);
+		if (new_begin == nullptr)
+			throw std::bad_alloc();
 		uint8_t* new_end = new_begin + (data_end - data_begin);
 
-		std::memcpy(new_begin, data_begin, data_end - data_begin);
-		delete[] data_begin;
+		// Relocate objects into the new storage
+		if (ops.move_construct != nullptr) {
+			for (uint8_t* src = data_begin, *dst = new_begin; src != data_end; src += stride, dst += stride) {
+				ops.move_construct(dst, src);
+			}
+			destroy_all();
+		} else if (data_begin != nullptr) {
+			std::memcpy(new_begin, data_begin, data_end - data_begin);
+		}
+		alignedFree(data_begin);
 
 		data_begin = new_begin;
 		data_end = new_end;
@@ -110,7 +263,7 @@ namespace yks {
 
 	void DynamicPoolAllocator::expand() {
 		if (data_alloc_end == data_begin) {
-			expand(4 * object_size);
+			expand(4 * stride);
 		} else {
 			expand((data_alloc_end - data_begin) * 2);
 		}
@@ -1,25 +1,87 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace yks {
 
+	/** Type-erased operations used to relocate and destroy objects of a type
+	 * only known at runtime. Null entries mean the type is trivial for that
+	 * operation, and memcpy or nothing is used instead. */
+	struct ObjectOps {
+		void (*move_construct)(void* dst, void* src);
+		void (*copy_construct)(void* dst, const void* src);
+		void (*destroy)(void* obj);
+
+		ObjectOps()
+			: move_construct(nullptr), copy_construct(nullptr), destroy(nullptr)
+		{}
+
+		/** False for move-only types, whose objects can't be duplicated. */
+		bool isCopyable() const {
+			return copy_construct != nullptr || move_construct == nullptr;
+		}
+
+		template <typename T>
+		static ObjectOps of() {
+			ObjectOps ops;
+			if (!std::is_trivially_copyable<T>::value) {
+				ops.move_construct = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); };
+				ops.copy_construct = copy_construct_of<T>(std::is_copy_constructible<T>());
+			}
+			if (!std::is_trivially_destructible<T>::value) {
+				ops.destroy = [](void* obj) { static_cast<T*>(obj)->~T(); };
+			}
+			return ops;
+		}
+
+	private:
+		template <typename T>
+		static void (*copy_construct_of(std::true_type))(void*, const void*) {
+			return [](void* dst, const void* src) { new (dst) T(*static_cast<const T*>(src)); };
+		}
+
+		template <typename T>
+		static void (*copy_construct_of(std::false_type))(void*, const void*) {
+			return nullptr;
+		}
+	};
+
 	struct DynamicPoolAllocator {
-		DynamicPoolAllocator(size_t object_size);
+		static const size_t default_alignment = 16;
+
+		DynamicPoolAllocator(size_t object_size, size_t alignment = default_alignment, const ObjectOps& ops = ObjectOps());
+		/** Throws std::logic_error if the type isn't copyable, as does assignment. */
 		DynamicPoolAllocator(const DynamicPoolAllocator& o);
 		~DynamicPoolAllocator();
 		DynamicPoolAllocator& operator =(const DynamicPoolAllocator& o);
 
 		size_t getObjectSize() const;
+		size_t getAlignment() const;
 
 		size_t size() const;
 		size_t capacity() const;
 		void reserve(size_t num);
+		size_t bytes() const;
 
+		/** Switches an empty allocator to a reserved range of address space
+		 * able to hold max_objects. Memory is then committed on demand and
+		 * growing never copies, at the cost of a fixed maximum size. Once
+		 * that is reached, growing throws std::bad_alloc. */
+		void reserveVirtual(size_t max_objects);
+
+		/** Returns uninitialized storage at the end. The caller must construct an object in it. */
 		void* push_back();
+		/** Copy-constructs src_data at the end. Throws std::logic_error if the type isn't copyable. */
 		void* push_back(const void* src_data);
+		/** Move-constructs src_data at the end, leaving it moved-from. Works for move-only types. */
+		void* push_back_move(void* src_data);
 		void pop_back();
-		void copy(size_t from, size_t to);
+		/** Replaces the object at `to` with the one at `from`, leaving `from` moved-from. */
+		void move(size_t from, size_t to);
 
 		void* begin() { return data_begin; }
 		void* end() { return data_end; }
@@ -31,10 +93,20 @@ namespace yks {
 
 	private:
 		size_t object_size;
+		size_t alignment;
+		// object_size rounded up to alignment
+		size_t stride;
+		ObjectOps ops;
+
 		uint8_t* data_begin;
 		uint8_t* data_end;
 		uint8_t* data_alloc_end;
+		// Size of the reserved address range, or 0 if allocated from the heap.
+		size_t reserved_bytes;
+
+		void free_storage();
 
+		void destroy_all();
 		void expand(size_t new_capacity_bytes);
 		void expand();
 	};
@@ -0,0 +1,80 @@
+#include "FrameArena.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace yks {
+
+	FrameArena::FrameArena(size_t initial_capacity)
+		: current_offset(0), full_blocks_used(0), growth_events(0)
+	{
+		add_block(initial_capacity);
+	}
+
+	FrameArena::~FrameArena() {
+		for (const Block& b : blocks) {
+			delete[] b.data;
+		}
+	}
+
+	void* FrameArena::allocate(size_t bytes, size_t alignment) {
+		assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+		Block* b = &blocks.back();
+		uintptr_t p = reinterpret_cast<uintptr_t>(b->data) + current_offset;
+		uintptr_t aligned = (p + alignment - 1) & ~uintptr_t(alignment - 1);
+		if (aligned + bytes > reinterpret_cast<uintptr_t>(b->data) + b->size) {
+			add_block(std::max(b->size * 2, bytes + alignment));
+			++growth_events;
+			b = &blocks.back();
+			p = reinterpret_cast<uintptr_t>(b->data);
+			aligned = (p + alignment - 1) & ~uintptr_t(alignment - 1);
+		}
+
+		current_offset = aligned + bytes - reinterpret_cast<uintptr_t>(b->data);
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	void FrameArena::reset() {
+		if (blocks.size() > 1) {
+			// Last frame didn't fit, replace everything with one block big enough for it
+			const size_t total = capacity();
+			for (const Block& b : blocks) {
+				delete[] b.data;
+			}
+			blocks.clear();
+			add_block(total);
+		}
+
+		current_offset = 0;
+		full_blocks_used = 0;
+	}
+
+	size_t FrameArena::bytesUsed() const {
+		return full_blocks_used + current_offset;
+	}
+
+	size_t FrameArena::capacity() const {
+		size_t total = 0;
+		for (const Block& b : blocks) {
+			total += b.size;
+		}
+		return total;
+	}
+
+	MemoryUsage FrameArena::getMemoryUsage() const {
+		return MemoryUsage(bytesUsed(), capacity(), capacity(), growth_events);
+	}
+
+	void FrameArena::add_block(size_t min_size) {
+		if (!blocks.empty()) {
+			full_blocks_used += current_offset;
+		}
+
+		Block b;
+		b.size = min_size;
+		b.data = new uint8_t[b.size];
+		blocks.push_back(b);
+		current_offset = 0;
+	}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "MemoryResource.hpp"
+#include "MemoryStats.hpp"
+#include "noncopyable.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace yks {
+
+	/** Linear allocator for temporaries that only live until the end of the
+	 * frame. Allocating bumps a pointer, and everything is freed at once by
+	 * reset(). If a frame overflows the arena, extra blocks are allocated and
+	 * then merged into a single larger one on the next reset, so the steady
+	 * state does no heap allocations.
+	 *
+	 * Being a MemoryResource, it can also back longer lived containers, e.g.
+	 * all of a level's pools, which are then freed at once on unload. */
+	struct FrameArena : MemoryResource {
+		explicit FrameArena(size_t initial_capacity = 64 * 1024);
+		~FrameArena();
+
+		void* allocate(size_t bytes, size_t alignment) override;
+		/** No-op, memory is only reclaimed by reset(). */
+		void deallocate(void*, size_t, size_t) override {}
+		/** Frees everything allocated since the last reset. */
+		void reset();
+
+		size_t bytesUsed() const;
+		size_t capacity() const;
+		MemoryUsage getMemoryUsage() const;
+
+	private:
+		struct Block {
+			uint8_t* data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks;
+		size_t current_offset;
+		// Bytes in blocks before the current one, which are all full.
+		size_t full_blocks_used;
+		size_t growth_events; // Overflow blocks added, for MemoryUsage
+
+		void add_block(size_t min_size);
+
+		NONCOPYABLE(FrameArena);
+	};
+
+}
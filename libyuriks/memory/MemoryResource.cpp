@@ -0,0 +1,37 @@
+#include "MemoryResource.hpp"
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+namespace yks {
+
+	struct HeapMemoryResource : MemoryResource {
+		void* allocate(size_t bytes, size_t alignment) override {
+			assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+			if (alignment <= heap_alignment) {
+				return ::operator new(bytes);
+			}
+
+			// Over-allocate, and keep the pointer to free just before the aligned block
+			void* raw = ::operator new(bytes + alignment + sizeof(void*));
+			const uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+			void** aligned = reinterpret_cast<void**>((start + alignment - 1) & ~uintptr_t(alignment - 1));
+			aligned[-1] = raw;
+			return aligned;
+		}
+
+		void deallocate(void* p, size_t, size_t alignment) override {
+			if (alignment <= heap_alignment) {
+				::operator delete(p);
+			} else if (p != nullptr) {
+				::operator delete(static_cast<void**>(p)[-1]);
+			}
+		}
+	};
+
+	MemoryResource* getHeapMemoryResource() {
+		static HeapMemoryResource heap;
+		return &heap;
+	}
+
+}
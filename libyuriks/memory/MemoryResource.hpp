@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace yks {
+
+	/** Source of memory that containers can be pointed at at runtime, in the
+	 * spirit of std::pmr::memory_resource. */
+	struct MemoryResource {
+		virtual ~MemoryResource() {}
+
+		virtual void* allocate(size_t bytes, size_t alignment) = 0;
+		virtual void deallocate(void* p, size_t bytes, size_t alignment) = 0;
+	};
+
+	/** Alignment operator new guarantees on the supported platforms. */
+	static const size_t heap_alignment = 2 * sizeof(void*);
+
+	/** Resource using the general heap. Used when no resource is given.
+	 * Larger alignments are handled by over-allocating. */
+	MemoryResource* getHeapMemoryResource();
+
+	/** Standard allocator drawing from a MemoryResource, so a container's
+	 * memory source can be picked per instance without changing its type.
+	 * Pointed at a FrameArena, deallocation is a no-op and memory is
+	 * reclaimed when the arena resets. */
+	template <typename T>
+	struct ResourceAllocator {
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind {
+			typedef ResourceAllocator<U> other;
+		};
+
+		MemoryResource* resource;
+
+		ResourceAllocator(MemoryResource* resource = nullptr)
+			: resource(resource != nullptr ? resource : getHeapMemoryResource())
+		{}
+
+		template <typename U>
+		ResourceAllocator(const ResourceAllocator<U>& o)
+			: resource(o.resource)
+		{}
+
+		T* allocate(size_t n) {
+			return static_cast<T*>(resource->allocate(n * sizeof(T), std::alignment_of<T>::value));
+		}
+
+		void deallocate(T* p, size_t n) {
+			resource->deallocate(p, n * sizeof(T), std::alignment_of<T>::value);
+		}
+
+		template <typename U>
+		bool operator==(const ResourceAllocator<U>& o) const {
+			return resource == o.resource;
+		}
+
+		template <typename U>
+		bool operator!=(const ResourceAllocator<U>& o) const {
+			return resource != o.resource;
+		}
+	};
+
+	/** Vector using a ResourceAllocator. Can be used as ObjectPool storage. */
+	template <typename T>
+	using ResourceVector = std::vector<T, ResourceAllocator<T>>;
+
+}
@@ -0,0 +1,240 @@
+#include "MemoryStats.hpp"
+#include "noexcept.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace yks {
+
+	static std::atomic<uint64_t> total_allocations(0);
+	static std::atomic<uint64_t> total_bytes(0);
+	static std::atomic<uint64_t> frame_allocations(0);
+	static std::atomic<uint64_t> frame_bytes(0);
+
+	HeapAllocationStats getHeapAllocationStats() {
+		HeapAllocationStats s;
+		s.total_allocations = total_allocations.load(std::memory_order_relaxed);
+		s.total_bytes = total_bytes.load(std::memory_order_relaxed);
+		s.frame_allocations = frame_allocations.load(std::memory_order_relaxed);
+		s.frame_bytes = frame_bytes.load(std::memory_order_relaxed);
+		return s;
+	}
+
+	void resetFrameHeapAllocationStats() {
+		frame_allocations.store(0, std::memory_order_relaxed);
+		frame_bytes.store(0, std::memory_order_relaxed);
+	}
+
+	MemoryStatsRegistry::MemoryStatsRegistry() {
+		last_frame_heap = getHeapAllocationStats();
+	}
+
+	void MemoryStatsRegistry::add_source(const std::string& name, const void* object, MemoryUsage (*poll)(const void*)) {
+		Source src;
+		src.name = name;
+		src.object = object;
+		src.poll = poll;
+		src.current = poll(object);
+		src.peak_bytes = src.current.bytes;
+		src.growth_events = 0;
+		src.growth_events_at_track = src.current.growth_events;
+		sources.push_back(src);
+	}
+
+	void MemoryStatsRegistry::untrack(const void* object) {
+		for (size_t i = 0; i < sources.size(); ++i) {
+			if (sources[i].object == object) {
+				sources.erase(sources.begin() + i);
+				return;
+			}
+		}
+	}
+
+	void MemoryStatsRegistry::sample() {
+		for (Source& src : sources) {
+			const MemoryUsage usage = src.poll(src.object);
+			src.growth_events = usage.growth_events - src.growth_events_at_track;
+			if (usage.bytes > src.peak_bytes) {
+				src.peak_bytes = usage.bytes;
+			}
+			src.current = usage;
+		}
+
+		last_frame_heap = getHeapAllocationStats();
+		resetFrameHeapAllocationStats();
+	}
+
+	MemoryUsage MemoryStatsRegistry::total() const {
+		MemoryUsage sum;
+		for (const Source& src : sources) {
+			sum += src.current;
+		}
+		return sum;
+	}
+
+	static void writeJsonString(std::ostream& s, const std::string& str) {
+		s << '"';
+		for (char c : str) {
+			if (c == '"' || c == '\\') {
+				s << '\\';
+			}
+			s << c;
+		}
+		s << '"';
+	}
+
+	void MemoryStatsRegistry::dumpJson(std::ostream& s) const {
+		const HeapAllocationStats& heap = last_frame_heap;
+		const MemoryUsage sum = total();
+
+		s << "{\n";
+		s << "  \"total_bytes\": " << sum.bytes << ",\n";
+		s << "  \"heap\": {\"total_allocations\": " << heap.total_allocations
+			<< ", \"total_bytes\": " << heap.total_bytes
+			<< ", \"frame_allocations\": " << heap.frame_allocations
+			<< ", \"frame_bytes\": " << heap.frame_bytes << "},\n";
+		s << "  \"pools\": [";
+		for (size_t i = 0; i < sources.size(); ++i) {
+			const Source& src = sources[i];
+			s << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+			writeJsonString(s, src.name);
+			s << ", \"live\": " << src.current.live_count
+				<< ", \"capacity\": " << src.current.capacity
+				<< ", \"bytes\": " << src.current.bytes
+				<< ", \"peak_bytes\": " << src.peak_bytes
+				<< ", \"growth_events\": " << src.growth_events << "}";
+		}
+		s << "\n  ]\n}\n";
+	}
+
+}
+
+#ifdef YKS_MEMORY_PROFILING
+
+static void countAllocation(size_t size) {
+	yks::total_allocations.fetch_add(1, std::memory_order_relaxed);
+	yks::total_bytes.fetch_add(size, std::memory_order_relaxed);
+	yks::frame_allocations.fetch_add(1, std::memory_order_relaxed);
+	yks::frame_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static void* allocateCounted(size_t size) {
+	countAllocation(size);
+	return std::malloc(size != 0 ? size : 1);
+}
+
+void* operator new(size_t size) {
+	if (void* p = allocateCounted(size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) YKS_NOEXCEPT {
+	return allocateCounted(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) YKS_NOEXCEPT {
+	return allocateCounted(size);
+}
+
+void operator delete(void* p) YKS_NOEXCEPT {
+	std::free(p);
+}
+
+void operator delete[](void* p) YKS_NOEXCEPT {
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) YKS_NOEXCEPT {
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) YKS_NOEXCEPT {
+	std::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, size_t) YKS_NOEXCEPT {
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) YKS_NOEXCEPT {
+	std::free(p);
+}
+#endif
+
+#ifdef __cpp_aligned_new
+static void* allocateCountedAligned(size_t size, std::align_val_t alignment) {
+	countAllocation(size);
+	const size_t align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+	return _aligned_malloc(size != 0 ? size : 1, align);
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment
+	return std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+#endif
+}
+
+static void freeAligned(void* p) {
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	if (void* p = allocateCountedAligned(size, alignment)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocateCountedAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocateCountedAligned(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+	freeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+	freeAligned(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+	freeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+	freeAligned(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+	freeAligned(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+	freeAligned(p);
+}
+#endif
+
+#endif
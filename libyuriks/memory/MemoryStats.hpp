@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace yks {
+
+	/** Snapshot of a container's memory use, reported by getMemoryUsage(). */
+	struct MemoryUsage {
+		size_t live_count;
+		size_t capacity;
+		size_t bytes;
+		// Times the capacity grew since the container was created, counted by
+		// the container when it happens. Zero for containers that don't count.
+		size_t growth_events;
+
+		MemoryUsage()
+			: live_count(0), capacity(0), bytes(0), growth_events(0)
+		{}
+
+		MemoryUsage(size_t live_count, size_t capacity, size_t bytes, size_t growth_events = 0)
+			: live_count(live_count), capacity(capacity), bytes(bytes), growth_events(growth_events)
+		{}
+
+		MemoryUsage& operator+=(const MemoryUsage& o) {
+			live_count += o.live_count;
+			capacity += o.capacity;
+			bytes += o.bytes;
+			growth_events += o.growth_events;
+			return *this;
+		}
+	};
+
+	/** Global heap allocation counters. Only updated in builds with
+	 * YKS_MEMORY_PROFILING defined, which replaces global operator new. */
+	struct HeapAllocationStats {
+		uint64_t total_allocations;
+		uint64_t total_bytes;
+		uint64_t frame_allocations;
+		uint64_t frame_bytes;
+	};
+
+	/** Keeps track of the memory use of registered containers. Each call to
+	 * sample() polls every source, recording peaks and how many times each
+	 * one's capacity grew since it was registered. */
+	struct MemoryStatsRegistry {
+		struct Source {
+			std::string name;
+			const void* object;
+			MemoryUsage (*poll)(const void*);
+
+			MemoryUsage current;
+			size_t peak_bytes;
+			size_t growth_events;
+			size_t growth_events_at_track; // Reported by the source when it was registered
+		};
+
+		std::vector<Source> sources;
+		// Heap counters as of the end of the last sampled frame.
+		HeapAllocationStats last_frame_heap;
+
+		MemoryStatsRegistry();
+
+		template <typename T>
+		void track(const std::string& name, const T& object) {
+			add_source(name, &object, [](const void* o) { return static_cast<const T*>(o)->getMemoryUsage(); });
+		}
+
+		void untrack(const void* object);
+
+		/** Polls all sources. Call once per frame. Also starts a new frame for allocation counting. */
+		void sample();
+
+		MemoryUsage total() const;
+		void dumpJson(std::ostream& s) const;
+
+	private:
+		void add_source(const std::string& name, const void* object, MemoryUsage (*poll)(const void*));
+	};
+
+	HeapAllocationStats getHeapAllocationStats();
+	void resetFrameHeapAllocationStats();
+
+}
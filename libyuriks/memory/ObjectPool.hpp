@@ -1,77 +1,271 @@
 #pragma once
 #include "Handle.hpp"
+#include "bits.hpp"
+#include "memory/MemoryResource.hpp"
+#include "memory/MemoryStats.hpp"
+#include "parallel.hpp"
+#include "prefetch.hpp"
+#include <algorithm>
 #include <cassert>
 #include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace yks {
 
-	/** Manages a pool of objects, providing persistent handles to them. */
+	/** Iterates a pool's dense storage, yielding (handle, object) pairs. */
+	template <typename Pool, typename T>
+	struct ObjectPoolIterator {
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<Handle, T&> value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef value_type reference;
+		typedef void pointer;
+
+		Pool* pool;
+		size_t index;
+
+		ObjectPoolIterator(Pool* pool, size_t index)
+			: pool(pool), index(pool->nextLive(index))
+		{}
+
+		value_type operator*() const {
+			return value_type(pool->makeHandle(index), pool->pool[index]);
+		}
+
+		ObjectPoolIterator& operator++() {
+			index = pool->nextLive(index + 1);
+			return *this;
+		}
+
+		bool operator==(const ObjectPoolIterator& o) const {
+			return index == o.index;
+		}
+
+		bool operator!=(const ObjectPoolIterator& o) const {
+			return !(*this == o);
+		}
+	};
+
+	enum class RemovalPolicy {
+		// Move the last object into the removed one's place.
+		swap_remove,
+		// Leave a tombstone in place and compact the pool later.
+		tombstone,
+	};
+
 	template <typename T>
+	using StdVector = std::vector<T>;
+
+	/** Manages a pool of objects, providing persistent handles to them.
+	 * Storage is the vector-like container used for the pool's arrays. Use
+	 * VirtualVector for very large pools that should grow in place, or
+	 * PagedVector to bound the cost of growing without reserving a range. */
+	template <typename T, template <typename> class Storage = StdVector>
 	struct ObjectPool {
-		size_t first_free_index; // in roster
+		typedef T value_type;
+		typedef ObjectPoolIterator<ObjectPool, T> iterator;
+		typedef ObjectPoolIterator<const ObjectPool, const T> const_iterator;
+
+		static const uint32_t null_index = UINT32_MAX;
+
+		uint32_t first_free_index; // in roster
 	
-		// For used entries: .index is index into pool.
-		// For free entries: .index is index of next free entry.
-		std::vector<Handle> roster;
+		// The roster, split in two parallel arrays so validating a handle only
+		// touches generation and finding its object only touches dense_index.
+		// For used entries: dense_index is index into pool.
+		// For free entries: dense_index is index of next free entry.
+		Storage<uint32_t> dense_index;
+		Storage<uint32_t> generation;
+
+		Storage<T> pool;
+		Storage<uint32_t> pool_indices; // Roster index of each pool entry
+
+		// One bit per pool entry, set for removed objects awaiting compaction.
+		// Tombstoned objects are only destroyed once compacted away.
+		Storage<uint64_t> tombstones;
+		size_t num_tombstones;
+
+		RemovalPolicy removal_policy;
+		// With the tombstone policy, compact once this fraction of the pool is holes.
+		float max_tombstone_ratio;
 
-		std::vector<T> pool;
-		std::vector<size_t> pool_indices;
+		size_t growth_events; // Times pool's capacity grew, for MemoryUsage
 
 		ObjectPool()
-			: first_free_index(SIZE_MAX)
+			: first_free_index(null_index), num_tombstones(0),
+			removal_policy(RemovalPolicy::swap_remove), max_tombstone_ratio(0.25f), growth_events(0)
+		{}
+
+		/** Allocates the pool's arrays from resource. Needs a Storage that takes
+		 * an allocator, like ResourceVector. */
+		explicit ObjectPool(MemoryResource* resource)
+			: first_free_index(null_index), dense_index(resource), generation(resource),
+			pool(resource), pool_indices(resource), tombstones(resource), num_tombstones(0),
+			removal_policy(RemovalPolicy::swap_remove), max_tombstone_ratio(0.25f), growth_events(0)
 		{}
 
 		template <typename... Args>
 		Handle emplace(Args&&... params) {
 			// Expand roster if we're out of entries
-			if (first_free_index >= roster.size()) {
+			if (first_free_index == null_index) {
 				expand_roster();
 			}
 
 			// Pop head off of free list
-			const size_t roster_index = first_free_index;
-			first_free_index = roster[roster_index].index;
+			const uint32_t roster_index = first_free_index;
+			first_free_index = dense_index[roster_index];
 
 			// Point roster entry to right place and insert object
-			roster[roster_index].index = pool.size();
+			dense_index[roster_index] = static_cast<uint32_t>(pool.size());
+			const size_t old_capacity = pool.capacity();
 			pool.emplace_back(std::forward<Args>(params)...);
 			pool_indices.push_back(roster_index);
+			count_growth(old_capacity);
+
+			return Handle(roster_index, generation[roster_index]);
+		}
+
+		/** Reserves space for a total of n objects. */
+		void reserve(size_t n) {
+			const size_t old_capacity = pool.capacity();
+			pool.reserve(n);
+			count_growth(old_capacity);
+			pool_indices.reserve(n);
+			if (dense_index.size() < n) {
+				dense_index.reserve(n);
+				generation.reserve(n);
+			}
+		}
+
+		/** Inserts count copies of init, which end up contiguous in pool starting
+		 * at the returned index. If out_handles isn't null, it receives the
+		 * handles of the new objects in the same order. */
+		size_t emplace_n(size_t count, const T& init, Handle* out_handles = nullptr) {
+			const size_t first_pool_index = pool.size();
+			reserve(first_pool_index + count);
+
+			for (size_t i = 0; i < count; ++i) {
+				if (first_free_index == null_index) {
+					expand_roster();
+				}
+
+				const uint32_t roster_index = first_free_index;
+				first_free_index = dense_index[roster_index];
+
+				dense_index[roster_index] = static_cast<uint32_t>(first_pool_index + i);
+				pool_indices.push_back(roster_index);
+				if (out_handles != nullptr) {
+					out_handles[i] = Handle(roster_index, generation[roster_index]);
+				}
+			}
+			pool.resize(first_pool_index + count, init);
+
+			return first_pool_index;
+		}
 
-			return Handle(roster_index, roster[roster_index].generation);
+		/** Removes several objects at once. Instead of swap-removing each one,
+		 * victims are marked and the pool is compacted in a single pass,
+		 * preserving the order of the remaining objects. */
+		void remove_many(const Handle* handles, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				tombstone(handles[i]);
+			}
+			compact();
 		}
 
 		void remove(const Handle h) {
+			if (removal_policy == RemovalPolicy::tombstone) {
+				tombstone(h);
+				if (num_tombstones > pool.size() * max_tombstone_ratio) {
+					compact();
+				}
+				return;
+			}
+
 			if (!isValid(h))
 				return;
 
 			// Indices for object being removed
-			const size_t roster_index = h.index;
-			const size_t pool_index = roster[roster_index].index;
+			const uint32_t roster_index = static_cast<uint32_t>(h.index);
+			const uint32_t pool_index = dense_index[roster_index];
 
 			// Indices for object being moved into its place
-			const size_t moved_roster_index = pool_indices.back();
+			const uint32_t moved_roster_index = pool_indices.back();
 			const size_t moved_pool_index = pool.size() - 1;
-			assert(roster[moved_roster_index].index == moved_pool_index);
+			assert(dense_index[moved_roster_index] == moved_pool_index);
 
 			// Move last element in place of the removed one, updating roster
-			roster[moved_roster_index].index = pool_index;
+			dense_index[moved_roster_index] = pool_index;
 			pool[pool_index] = std::move(pool[moved_pool_index]);
 			pool.pop_back();
 			pool_indices[pool_index] = pool_indices[moved_pool_index];
 			pool_indices.pop_back();
 
 			// Increment generation of removed roster entry and add it to free list
-			++roster[roster_index].generation;
-			roster[roster_index].index = first_free_index;
-			first_free_index = roster_index;
+			free_roster_entry(roster_index);
+		}
+
+		/** Switching back to swap_remove compacts away any pending tombstones. */
+		void setRemovalPolicy(RemovalPolicy policy) {
+			removal_policy = policy;
+			if (policy == RemovalPolicy::swap_remove) {
+				compact();
+			}
+		}
+
+		/** Removes all tombstones, keeping the remaining objects in order. */
+		void compact() {
+			if (num_tombstones == 0)
+				return;
+
+			size_t dst = nextTombstone(0);
+			for (size_t src = dst; src < pool.size(); ++src) {
+				if (isTombstone(src))
+					continue;
+
+				pool[dst] = std::move(pool[src]);
+				pool_indices[dst] = pool_indices[src];
+				dense_index[pool_indices[dst]] = static_cast<uint32_t>(dst);
+				++dst;
+			}
+			pool.erase(pool.begin() + dst, pool.end());
+			pool_indices.resize(dst);
+
+			tombstones.clear();
+			num_tombstones = 0;
+		}
+
+		bool isTombstone(size_t index) const {
+			const size_t word = index / 64;
+			return word < tombstones.size() && (tombstones[word] & (uint64_t(1) << (index % 64)));
+		}
+
+		/** Returns the first pool index >= index that holds a live object, or pool.size(). */
+		size_t nextLive(size_t index) const {
+			if (num_tombstones == 0 || index >= pool.size())
+				return std::min(index, pool.size());
+
+			size_t word = index / 64;
+			if (word >= tombstones.size())
+				return index;
+
+			uint64_t live = ~tombstones[word] & (~uint64_t(0) << (index % 64));
+			while (live == 0) {
+				if (++word == tombstones.size())
+					return std::min(word * 64, pool.size());
+				live = ~tombstones[word];
+			}
+			return std::min(word * 64 + countTrailingZeros(live), pool.size());
 		}
 
 		T* operator[] (const Handle h) {
 			if (isValid(h)) {
-				assert(roster[h.index].index < pool.size());
-				return &pool[roster[h.index].index];
+				assert(dense_index[h.index] < pool.size());
+				return &pool[dense_index[h.index]];
 			} else {
 				return nullptr;
 			}
@@ -79,43 +273,128 @@ namespace yks {
 
 		const T* operator[] (const Handle h) const {
 			if (isValid(h)) {
-				assert(roster[h.index].index < pool.size());
-				return &pool[roster[h.index].index];
+				assert(dense_index[h.index] < pool.size());
+				return &pool[dense_index[h.index]];
 			} else {
 				return nullptr;
 			}
 		}
 
+		/** Looks up count handles at once, writing a pointer to each object to
+		 * out, or null for invalid handles. All roster entries are prefetched
+		 * before any is read, and then all objects, so their cache misses
+		 * overlap instead of each lookup waiting on two in a row. */
+		void resolve_many(const Handle* handles, size_t count, T** out) {
+			for (size_t i = 0; i < count; ++i) {
+				if (handles[i].index < generation.size()) {
+					prefetch(&generation[handles[i].index]);
+					prefetch(&dense_index[handles[i].index]);
+				}
+			}
+			for (size_t i = 0; i < count; ++i) {
+				if (isValid(handles[i])) {
+					out[i] = &pool[dense_index[handles[i].index]];
+					prefetch(out[i]);
+				} else {
+					out[i] = nullptr;
+				}
+			}
+		}
+
 		/** Checks if object referenced by handle is still in the pool. */
 		bool isValid(const Handle h) const {
-			return h.index < roster.size() && roster[h.index].generation == h.generation;
+			return h.index < generation.size() && generation[h.index] == h.generation;
 		}
 
 		/** Creates a handle to the object currently at pool[index]. */
 		Handle makeHandle(size_t index) const {
-			if (index >= pool.size())
+			if (index >= pool.size() || isTombstone(index))
 				return Handle();
 			else
-				return Handle(index, roster[pool_indices[index]].generation);
+				return Handle(pool_indices[index], generation[pool_indices[index]]);
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, pool.size()); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, pool.size()); }
+
+		/** Calls fn(handle, object) for every object, splitting the pool
+		 * across threads. fn must not add or remove objects. */
+		template <typename Fn>
+		void parallel_for_each(const Fn& fn, size_t min_chunk = 1024) {
+			parallel_for(pool.size(), min_chunk, [this, &fn](size_t begin, size_t end) {
+				for (size_t i = nextLive(begin); i < end; i = nextLive(i + 1)) {
+					fn(Handle(pool_indices[i], generation[pool_indices[i]]), pool[i]);
+				}
+			});
+		}
+
+		/** Number of live objects, not counting tombstones. */
+		size_t size() const {
+			return pool.size() - num_tombstones;
+		}
+
+		MemoryUsage getMemoryUsage() const {
+			return MemoryUsage(size(), pool.capacity(),
+				(dense_index.capacity() + generation.capacity()) * sizeof(uint32_t) + pool.capacity() * sizeof(T)
+				+ pool_indices.capacity() * sizeof(uint32_t) + tombstones.capacity() * sizeof(uint64_t),
+				growth_events);
 		}
 
 		/** Get index into pool for handle. */
 		size_t getPoolIndex(const Handle h) const {
 			if (isValid(h)) {
-				return roster[h.index].index;
+				return dense_index[h.index];
 			} else {
 				return SIZE_MAX;
 			}
 		}
 
 	private:
-		void expand_roster() {
-			const Handle new_entry(first_free_index, 0);
+		void count_growth(size_t old_capacity) {
+			if (pool.capacity() > old_capacity) {
+				++growth_events;
+			}
+		}
+
+		void free_roster_entry(uint32_t roster_index) {
+			++generation[roster_index];
+			dense_index[roster_index] = first_free_index;
+			first_free_index = roster_index;
+		}
+
+		void tombstone(const Handle h) {
+			if (!isValid(h))
+				return;
+
+			const size_t pool_index = dense_index[h.index];
+			const size_t word = pool_index / 64;
+			if (word >= tombstones.size()) {
+				tombstones.resize(word + 1);
+			}
+			tombstones[word] |= uint64_t(1) << (pool_index % 64);
+			++num_tombstones;
+
+			// Free roster entry right away, so the handle is immediately invalid
+			free_roster_entry(static_cast<uint32_t>(h.index));
+		}
 
-			first_free_index = roster.size();
-			roster.push_back(new_entry);
+		size_t nextTombstone(size_t index) const {
+			for (size_t word = index / 64; word < tombstones.size(); ++word) {
+				if (tombstones[word] != 0) {
+					return word * 64 + countTrailingZeros(tombstones[word]);
+				}
+			}
+			return pool.size();
+		}
+
+		void expand_roster() {
+			assert(dense_index.size() < null_index);
 
-			assert(first_free_index < roster.size());
+			dense_index.push_back(first_free_index);
+			generation.push_back(0);
+			first_free_index = static_cast<uint32_t>(dense_index.size() - 1);
 		}
 	};
 
@@ -0,0 +1,190 @@
+#pragma once
+#include "memory/MemoryResource.hpp"
+#include "noncopyable.hpp"
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace yks {
+
+	/** Random access iterator over a PagedVector, by index. */
+	template <typename Vec, typename T>
+	struct PagedVectorIterator {
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef typename std::remove_const<T>::type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef T& reference;
+		typedef T* pointer;
+
+		Vec* vec;
+		size_t index;
+
+		PagedVectorIterator()
+			: vec(nullptr), index(0)
+		{}
+
+		PagedVectorIterator(Vec* vec, size_t index)
+			: vec(vec), index(index)
+		{}
+
+		T& operator*() const { return (*vec)[index]; }
+		T* operator->() const { return &(*vec)[index]; }
+		T& operator[](difference_type n) const { return (*vec)[index + n]; }
+
+		PagedVectorIterator& operator++() { ++index; return *this; }
+		PagedVectorIterator& operator--() { --index; return *this; }
+		PagedVectorIterator operator++(int) { PagedVectorIterator old = *this; ++index; return old; }
+		PagedVectorIterator operator--(int) { PagedVectorIterator old = *this; --index; return old; }
+		PagedVectorIterator& operator+=(difference_type n) { index += n; return *this; }
+		PagedVectorIterator& operator-=(difference_type n) { index -= n; return *this; }
+		PagedVectorIterator operator+(difference_type n) const { return PagedVectorIterator(vec, index + n); }
+		PagedVectorIterator operator-(difference_type n) const { return PagedVectorIterator(vec, index - n); }
+		difference_type operator-(const PagedVectorIterator& o) const { return difference_type(index) - difference_type(o.index); }
+
+		bool operator==(const PagedVectorIterator& o) const { return index == o.index; }
+		bool operator!=(const PagedVectorIterator& o) const { return index != o.index; }
+		bool operator<(const PagedVectorIterator& o) const { return index < o.index; }
+		bool operator>(const PagedVectorIterator& o) const { return index > o.index; }
+		bool operator<=(const PagedVectorIterator& o) const { return index <= o.index; }
+		bool operator>=(const PagedVectorIterator& o) const { return index >= o.index; }
+	};
+
+	/** Vector-like container storing its elements in fixed-size pages of
+	 * page_bytes. Growing only allocates a new page, so elements are never
+	 * moved and pointers to them stay valid until the element itself is
+	 * popped. Can be used as ObjectPool storage, as ObjectPool<T, PagedVector>,
+	 * which bounds the cost of emplace however large the pool gets. */
+	template <typename T>
+	struct PagedVector {
+		typedef T value_type;
+		typedef PagedVectorIterator<PagedVector, T> iterator;
+		typedef PagedVectorIterator<const PagedVector, const T> const_iterator;
+
+		static const size_t page_bytes = 16 * 1024;
+
+		// Largest power of two that fits in a page, so indexing is a shift and a mask
+		static const size_t page_shift =
+			sizeof(T) * 2048 <= page_bytes ? 11 : sizeof(T) * 1024 <= page_bytes ? 10 :
+			sizeof(T) * 512 <= page_bytes ? 9 : sizeof(T) * 256 <= page_bytes ? 8 :
+			sizeof(T) * 128 <= page_bytes ? 7 : sizeof(T) * 64 <= page_bytes ? 6 :
+			sizeof(T) * 32 <= page_bytes ? 5 : sizeof(T) * 16 <= page_bytes ? 4 :
+			sizeof(T) * 8 <= page_bytes ? 3 : sizeof(T) * 4 <= page_bytes ? 2 :
+			sizeof(T) * 2 <= page_bytes ? 1 : 0;
+		static const size_t elements_per_page = size_t(1) << page_shift;
+		static const size_t page_mask = elements_per_page - 1;
+
+		/** Allocates pages from resource, or from the heap if it's null. */
+		explicit PagedVector(MemoryResource* resource = nullptr)
+			: pages(ResourceAllocator<T*>(resource)), count(0)
+		{}
+
+		~PagedVector() {
+			clear();
+			for (T* page : pages) {
+				pages.get_allocator().resource->deallocate(page, elements_per_page * sizeof(T), std::alignment_of<T>::value);
+			}
+		}
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		size_t capacity() const { return pages.size() * elements_per_page; }
+
+		void reserve(size_t n) {
+			while (capacity() < n) {
+				add_page();
+			}
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... params) {
+			if (count == capacity()) {
+				add_page();
+			}
+			T* p = &pages[count >> page_shift][count & page_mask];
+			new (p) T(std::forward<Args>(params)...);
+			++count;
+			return *p;
+		}
+
+		void push_back(const T& val) {
+			emplace_back(val);
+		}
+
+		void pop_back() {
+			assert(count > 0);
+			--count;
+			pages[count >> page_shift][count & page_mask].~T();
+		}
+
+		void resize(size_t n) {
+			resize(n, T());
+		}
+
+		void resize(size_t n, const T& val) {
+			reserve(n);
+			while (count > n) {
+				pop_back();
+			}
+			while (count < n) {
+				emplace_back(val);
+			}
+		}
+
+		iterator erase(iterator first, iterator last) {
+			iterator new_end = std::move(last, end(), first);
+			while (end() != new_end) {
+				pop_back();
+			}
+			return first;
+		}
+
+		void clear() {
+			while (count > 0) {
+				pop_back();
+			}
+		}
+
+		T& back() { return (*this)[count - 1]; }
+		const T& back() const { return (*this)[count - 1]; }
+
+		T& operator[] (size_t i) {
+			assert(i < count);
+			return pages[i >> page_shift][i & page_mask];
+		}
+
+		const T& operator[] (size_t i) const {
+			assert(i < count);
+			return pages[i >> page_shift][i & page_mask];
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, count); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, count); }
+
+		/** Pages can be iterated directly for dense, contiguous access. */
+		size_t numPages() const { return (count + page_mask) >> page_shift; }
+		T* pageData(size_t page) { return pages[page]; }
+		const T* pageData(size_t page) const { return pages[page]; }
+		size_t pageSize(size_t page) const {
+			const size_t first = page << page_shift;
+			return count - first < elements_per_page ? count - first : elements_per_page;
+		}
+
+	private:
+		ResourceVector<T*> pages;
+		size_t count;
+
+		void add_page() {
+			// The resource honours over-aligned types, unlike plain operator new
+			void* page = pages.get_allocator().resource->allocate(elements_per_page * sizeof(T), std::alignment_of<T>::value);
+			pages.push_back(static_cast<T*>(page));
+		}
+
+		NONCOPYABLE(PagedVector);
+	};
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Handle.hpp"
+#include "SortedVector.hpp"
+#include "memory/ObjectPool.hpp"
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+
+namespace yks {
+
+	/** Pool of deduplicated, immutable values. Inserting a value equal to one
+	 * already in the pool returns a handle to the existing instance, which is
+	 * reference counted and only freed once every user removes it.
+	 * T must be copyable and have operator< and operator==. */
+	template <typename T>
+	struct SharedObjectPool {
+		struct Entry {
+			T value;
+			uint32_t ref_count;
+
+			Entry(const T& value)
+				: value(value), ref_count(1)
+			{}
+		};
+
+		ObjectPool<Entry> pool;
+		SortedVector<std::tuple<T, Handle>> lookup_table;
+
+		Handle insert(const T& value) {
+			auto pos = lookup_table.lookup(value);
+			if (pos != lookup_table.data.end()) {
+				Handle h = std::get<1>(*pos);
+				++pool[h]->ref_count;
+				return h;
+			}
+
+			Handle h = pool.emplace(value);
+			lookup_table.insert(std::make_tuple(value, h));
+			return h;
+		}
+
+		template <typename... Args>
+		Handle emplace(Args&&... params) {
+			return insert(T(std::forward<Args>(params)...));
+		}
+
+		/** Drops one reference to the value, freeing it if it was the last. */
+		void remove(const Handle h) {
+			Entry* e = pool[h];
+			if (e == nullptr)
+				return;
+
+			if (--e->ref_count == 0) {
+				lookup_table.remove(e->value);
+				pool.remove(h);
+			}
+		}
+
+		const T* operator[] (const Handle h) const {
+			const Entry* e = pool[h];
+			return e != nullptr ? &e->value : nullptr;
+		}
+
+		bool isValid(const Handle h) const {
+			return pool.isValid(h);
+		}
+
+		MemoryUsage getMemoryUsage() const {
+			MemoryUsage usage = pool.getMemoryUsage();
+			usage.bytes += lookup_table.getMemoryUsage().bytes;
+			return usage;
+		}
+
+		/** Number of distinct values in the pool. */
+		size_t size() const {
+			return pool.size();
+		}
+	};
+
+}
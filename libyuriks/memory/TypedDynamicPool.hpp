@@ -7,14 +7,17 @@ namespace yks {
 	/** Manages a pool of objects, providing persistent handles to them. */
 	template <typename T>
 	struct TypedDynamicPool : DynamicPool {
-		static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
-
 		TypedDynamicPool()
-			: DynamicPool(sizeof(T))
+			: DynamicPool(sizeof(T), std::alignment_of<T>::value, ObjectOps::of<T>())
 		{}
 
 		Handle insert(const T& object) {
-			return insert(static_cast<const void*>(&object));
+			static_assert(std::is_copy_constructible<T>::value, "T isn't copyable, insert it by rvalue instead.");
+			return std::get<0>(DynamicPool::insert(static_cast<const void*>(&object)));
+		}
+
+		Handle insert(T&& object) {
+			return std::get<0>(DynamicPool::insertMoved(static_cast<void*>(&object)));
 		}
 
 		template <typename... Args>
@@ -0,0 +1,51 @@
+#include "VirtualMemory.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace yks {
+
+#ifdef _WIN32
+
+	void* reserveAddressSpace(size_t bytes) {
+		return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+	}
+
+	bool commitMemory(void* p, size_t bytes) {
+		// Large pages on Windows need a special privilege, so only regular pages are used.
+		return VirtualAlloc(p, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	}
+
+	void releaseAddressSpace(void* p, size_t) {
+		VirtualFree(p, 0, MEM_RELEASE);
+	}
+
+#else
+
+	void* reserveAddressSpace(size_t bytes) {
+		void* p = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return p != MAP_FAILED ? p : nullptr;
+	}
+
+	bool commitMemory(void* p, size_t bytes) {
+		if (mprotect(p, bytes, PROT_READ | PROT_WRITE) != 0) {
+			return false;
+		}
+#ifdef MADV_HUGEPAGE
+		madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+		return true;
+	}
+
+	void releaseAddressSpace(void* p, size_t bytes) {
+		munmap(p, bytes);
+	}
+
+#endif
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+namespace yks {
+
+	/** Granularity used when committing reserved memory. Matches the usual
+	 * huge page size, so committed ranges can be backed by huge pages. */
+	static const size_t virtual_commit_granularity = 2 * 1024 * 1024;
+
+	/** Reserves a range of address space without backing it with memory.
+	 * Returns null on failure. */
+	void* reserveAddressSpace(size_t bytes);
+	/** Backs [p, p + bytes) of a reserved range with readable and writable
+	 * memory, hinting the OS to use huge pages where supported. */
+	bool commitMemory(void* p, size_t bytes);
+	/** Releases a whole range returned by reserveAddressSpace. */
+	void releaseAddressSpace(void* p, size_t bytes);
+
+	/** Rounds bytes up to virtual_commit_granularity. */
+	inline size_t roundUpToCommitGranularity(size_t bytes) {
+		return (bytes + virtual_commit_granularity - 1) / virtual_commit_granularity * virtual_commit_granularity;
+	}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "memory/VirtualMemory.hpp"
+#include "noncopyable.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace yks {
+
+	/** Vector-like container backed by a reserved range of address space.
+	 * Memory is committed on demand as it grows, so growing never moves
+	 * elements or needs twice the memory like std::vector does. */
+	template <typename T>
+	struct VirtualVector {
+		typedef T value_type;
+		typedef T* iterator;
+		typedef const T* const_iterator;
+
+		// Address space reserved per container. Kept small on 32-bit targets.
+		static const size_t default_reserve_bytes = sizeof(void*) >= 8 ? size_t(1) << 36 : size_t(1) << 26;
+
+		explicit VirtualVector(size_t max_bytes = default_reserve_bytes)
+			: data_begin(nullptr), count(0), committed_bytes(0),
+			reserved_bytes(roundUpToCommitGranularity(max_bytes))
+		{}
+
+		~VirtualVector() {
+			clear();
+			if (data_begin != nullptr) {
+				releaseAddressSpace(data_begin, reserved_bytes);
+			}
+		}
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		size_t capacity() const { return committed_bytes / sizeof(T); }
+		size_t max_size() const { return reserved_bytes / sizeof(T); }
+
+		void reserve(size_t n) {
+			if (n <= capacity())
+				return;
+
+			if (data_begin == nullptr) {
+				data_begin = static_cast<T*>(reserveAddressSpace(reserved_bytes));
+				if (data_begin == nullptr)
+					throw std::bad_alloc();
+			}
+
+			const size_t new_bytes = std::min(roundUpToCommitGranularity(n * sizeof(T)), reserved_bytes);
+			if (n > new_bytes / sizeof(T) || !commitMemory(reinterpret_cast<char*>(data_begin) + committed_bytes, new_bytes - committed_bytes))
+				throw std::bad_alloc();
+			committed_bytes = new_bytes;
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... params) {
+			reserve(count + 1);
+			T* p = new (data_begin + count) T(std::forward<Args>(params)...);
+			++count;
+			return *p;
+		}
+
+		void push_back(const T& val) {
+			emplace_back(val);
+		}
+
+		void pop_back() {
+			assert(count > 0);
+			data_begin[--count].~T();
+		}
+
+		void resize(size_t n) {
+			resize(n, T());
+		}
+
+		void resize(size_t n, const T& val) {
+			reserve(n);
+			while (count > n) {
+				pop_back();
+			}
+			while (count < n) {
+				new (data_begin + count) T(val);
+				++count;
+			}
+		}
+
+		iterator erase(iterator first, iterator last) {
+			iterator new_end = std::move(last, end(), first);
+			while (end() != new_end) {
+				pop_back();
+			}
+			return first;
+		}
+
+		void clear() {
+			while (count > 0) {
+				pop_back();
+			}
+		}
+
+		T& back() { return data_begin[count - 1]; }
+		const T& back() const { return data_begin[count - 1]; }
+
+		T& operator[] (size_t i) {
+			assert(i < count);
+			return data_begin[i];
+		}
+
+		const T& operator[] (size_t i) const {
+			assert(i < count);
+			return data_begin[i];
+		}
+
+		T* data() { return data_begin; }
+		const T* data() const { return data_begin; }
+		iterator begin() { return data_begin; }
+		iterator end() { return data_begin + count; }
+		const_iterator begin() const { return data_begin; }
+		const_iterator end() const { return data_begin + count; }
+
+	private:
+		T* data_begin;
+		size_t count;
+		// Kept in bytes, since the commit granularity need not be a multiple of sizeof(T)
+		size_t committed_bytes;
+		size_t reserved_bytes;
+
+		NONCOPYABLE(VirtualVector);
+	};
+
+}
@@ -0,0 +1,7 @@
+#pragma once
+// VS2013 doesn't support noexcept, throw() is the closest it has.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define YKS_NOEXCEPT throw()
+#else
+#define YKS_NOEXCEPT noexcept
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstddef>
+
+namespace yks {
+
+	/** Splits [0, count) into contiguous chunks of at least min_chunk items and
+	 * calls fn(begin, end) for each of them on the default thread pool. The
+	 * calling thread processes chunks too, and this returns once all are done.
+	 * Called from inside another pool job, all chunks run on the calling thread. */
+	template <typename Fn>
+	void parallel_for(size_t count, size_t min_chunk, const Fn& fn) {
+		if (count == 0)
+			return;
+
+		size_t num_chunks = std::max<size_t>(count / std::max<size_t>(min_chunk, 1), 1);
+		if (num_chunks > 1 && !ThreadPool::isInsideJob()) {
+			num_chunks = std::min(num_chunks, ThreadPool::getDefault().numThreads());
+		} else {
+			num_chunks = 1;
+		}
+
+		if (num_chunks <= 1) {
+			fn(size_t(0), count);
+			return;
+		}
+
+		const size_t chunk = (count + num_chunks - 1) / num_chunks;
+		ThreadPool::getDefault().run(num_chunks, [&fn, chunk, count](size_t i) {
+			const size_t begin = i * chunk;
+			if (begin < count) {
+				fn(begin, std::min(begin + chunk, count));
+			}
+		});
+	}
+
+}
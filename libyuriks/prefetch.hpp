@@ -0,0 +1,18 @@
+#pragma once
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+namespace yks {
+
+	/** Hints the CPU to start loading the cache line containing p. Never faults. */
+	inline void prefetch(const void* p) {
+#ifdef _MSC_VER
+		_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+		__builtin_prefetch(p);
+#endif
+	}
+
+}
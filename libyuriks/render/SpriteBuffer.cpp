@@ -118,7 +118,9 @@ namespace yks {
 		YKS_CHECK_GL_PARANOID;
 	}
 
-	SpriteBuffer::SpriteBuffer() {
+	SpriteBuffer::SpriteBuffer(MemoryResource* resource)
+		: vertices(resource)
+	{
 		YKS_CHECK_GL_PARANOID;
 
 		glGenBuffers(1, &vbo.name);
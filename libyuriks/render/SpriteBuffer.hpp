@@ -8,6 +8,7 @@
 #include "Sprite.hpp"
 #include "math/vec.hpp"
 #include "math/Complex.hpp"
+#include "memory/MemoryResource.hpp"
 #include <memory>
 
 namespace yks {
@@ -45,13 +46,13 @@ namespace yks {
 	};
 
 	struct SpriteBuffer {
-		std::vector<VertexData> vertices;
+		std::vector<VertexData, ResourceAllocator<VertexData>> vertices;
 
 		unsigned int sprite_count = 0;
 		gl::Buffer vbo;
 		vec2i texture_size = {{-1, -1}};
 
-		SpriteBuffer();
+		explicit SpriteBuffer(MemoryResource* resource = nullptr);
 
 		void clear();
 		void append(const Sprite& spr);
@@ -3,11 +3,20 @@
 #include <unordered_map>
 #include <string>
 #include "Sprite.hpp"
+#include "memory/MemoryResource.hpp"
 
 namespace yks {
 
 	struct SpriteDb {
-		std::unordered_map<std::string, IntRect> sprite_db;
+		typedef std::unordered_map<std::string, IntRect, std::hash<std::string>, std::equal_to<std::string>,
+			ResourceAllocator<std::pair<const std::string, IntRect>>> Map;
+
+		// Map nodes come from the resource. Sprite names still use the heap.
+		Map sprite_db;
+
+		explicit SpriteDb(MemoryResource* resource = nullptr)
+			: sprite_db(0, Map::hasher(), Map::key_equal(), Map::allocator_type(resource))
+		{}
 
 		IntRect lookup(const std::string& id) const { return sprite_db.at(id); }
 		std::vector<IntRect> lookupSequence(const std::string& id_prefix) const;
@@ -4,17 +4,29 @@
 namespace yks {
 
 	int measureStringWidth(const std::string& text, const FontInfo& font) {
-		return text.length() * font.char_w;
+		return measureStringWidth(text.data(), text.length(), font);
+	}
+
+	int measureStringWidth(const char* text, size_t length, const FontInfo& font) {
+		return length * font.char_w;
 	}
 
 	void drawString(int x, int y, const std::string& text, SpriteBuffer& buffer, const FontInfo& font, const Color& color) {
+		drawString(x, y, text.data(), text.length(), buffer, font, color);
+	}
+
+	void drawString(int x, int y, const std::string& text, SpriteBuffer& buffer, const FontInfo& font, TextAlignment alignment, const Color& color) {
+		drawString(x, y, text.data(), text.length(), buffer, font, alignment, color);
+	}
+
+	void drawString(int x, int y, const char* text, size_t length, SpriteBuffer& buffer, const FontInfo& font, const Color& color) {
 		Sprite spr;
 		spr.setPos(x, y);
 		spr.setImg(font.img_x, font.img_y, font.char_w, font.char_h);
 		spr.color = color;
 
-		for (char c : text) {
-			const int grid_pos = c - font.first_char;
+		for (size_t i = 0; i < length; ++i) {
+			const int grid_pos = text[i] - font.first_char;
 			const int grid_line = grid_pos / font.grid_w;
 			const int grid_col = grid_pos % font.grid_w;
 			assert(grid_line < font.grid_h);
@@ -26,20 +38,20 @@ namespace yks {
 		}
 	}
 
-	void drawString(int x, int y, const std::string& text, SpriteBuffer& buffer, const FontInfo& font, TextAlignment alignment, const Color& color) {
+	void drawString(int x, int y, const char* text, size_t length, SpriteBuffer& buffer, const FontInfo& font, TextAlignment alignment, const Color& color) {
 		switch (alignment) {
 		case TextAlignment::left:
 			break;
 		case TextAlignment::right:
-			x = x - measureStringWidth(text, font);
+			x = x - measureStringWidth(text, length, font);
 			break;
 		case TextAlignment::center:
 			// The weird position dance is so that it rounds down instead of up.
-			x = (2*x - measureStringWidth(text, font)) / 2;
+			x = (2*x - measureStringWidth(text, length, font)) / 2;
 			break;
 		}
 
-		drawString(x, y, text, buffer, font, color);
+		drawString(x, y, text, length, buffer, font, color);
 	}
 
 }
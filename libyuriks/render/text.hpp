@@ -23,7 +23,11 @@ namespace yks {
 	};
 
 	int measureStringWidth(const std::string& text, const FontInfo& font);
+	int measureStringWidth(const char* text, size_t length, const FontInfo& font);
 	void drawString(int x, int y, const std::string& text, SpriteBuffer& buffer, const FontInfo& font, const Color& color);
 	void drawString(int x, int y, const std::string& text, SpriteBuffer& buffer, const FontInfo& font, TextAlignment alignment, const Color& color);
+	// Overloads taking character ranges, so text formatted into scratch memory needs no std::string.
+	void drawString(int x, int y, const char* text, size_t length, SpriteBuffer& buffer, const FontInfo& font, const Color& color);
+	void drawString(int x, int y, const char* text, size_t length, SpriteBuffer& buffer, const FontInfo& font, TextAlignment alignment, const Color& color);
 
 }
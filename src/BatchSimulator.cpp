@@ -0,0 +1,28 @@
+#include "BatchSimulator.hpp"
+
+BatchSimulator::BatchSimulator(size_t num_worlds, uint64_t seed, size_t num_threads)
+	: thread_pool(num_threads)
+{
+	worlds.resize(num_worlds);
+	// Construct in parallel too, so each world's memory is first touched by a worker
+	thread_pool.run(num_worlds, [seed, this](size_t i) {
+		worlds[i].reset(new GameWorld(worldSeed(seed, i)));
+	});
+}
+
+void BatchSimulator::step(uint64_t num_ticks) {
+	forEachWorld([num_ticks](GameWorld& world, size_t) {
+		for (uint64_t t = 0; t < num_ticks; ++t) {
+			world.update();
+		}
+	});
+}
+
+uint32_t BatchSimulator::worldSeed(uint64_t batch_seed, size_t index) {
+	// splitmix64, so neighbouring indices get unrelated seeds
+	uint64_t z = batch_seed + (uint64_t(index) + 1) * 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	z ^= z >> 31;
+	return static_cast<uint32_t>(z);
+}
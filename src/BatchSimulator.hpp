@@ -0,0 +1,36 @@
+#pragma once
+#include "GameWorld.hpp"
+#include "ThreadPool.hpp"
+#include "noncopyable.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/** Runs many independent headless GameWorlds at once, spread over a thread
+ * pool, e.g. for automated level validation. Each world's seed depends only
+ * on the batch seed and its index, so runs are reproducible regardless of
+ * how the worlds get scheduled. */
+struct BatchSimulator {
+	std::vector<std::unique_ptr<GameWorld>> worlds;
+	yks::ThreadPool thread_pool;
+
+	/** With num_threads = 0, uses all hardware threads. */
+	BatchSimulator(size_t num_worlds, uint64_t seed, size_t num_threads = 0);
+
+	/** Calls fn(world, index) for every world, in parallel. fn must only touch the world it's given. */
+	template <typename Fn>
+	void forEachWorld(const Fn& fn) {
+		thread_pool.run(worlds.size(), [this, &fn](size_t i) {
+			fn(*worlds[i], i);
+		});
+	}
+
+	/** Updates every world num_ticks times. */
+	void step(uint64_t num_ticks = 1);
+
+	/** Seed given to the world at index in a batch with the given seed. */
+	static uint32_t worldSeed(uint64_t batch_seed, size_t index);
+
+	NONCOPYABLE(BatchSimulator);
+};
@@ -0,0 +1,166 @@
+#include "Collision.hpp"
+#include "EntityQuery.hpp"
+#include "bits.hpp"
+#include <algorithm>
+#include <limits>
+
+#if defined(_MSC_VER) || defined(__SSE__)
+#include <xmmintrin.h>
+#define COLLISION_USE_SSE
+#endif
+
+CollisionSystem::CollisionSystem()
+	: stamp(0)
+{}
+
+void CollisionSystem::clear() {
+	contacts.clear();
+	proxies.clear();
+	entity_proxies.clear();
+}
+
+void CollisionSystem::update(EntityWorld& world, const yks::ObjectPool<Position>& positions, const yks::ObjectPool<Collider>& colliders) {
+	++stamp;
+
+	// Refresh the boxes in place, so the previous order stays nearly sorted
+	size_t num_appended = 0;
+	auto q = query(world, Position::component_id, Collider::component_id);
+	for (auto it = q.begin(); it != q.end(); ++it) {
+		const auto handles = *it;
+		const Position* pos = positions[handles[0]];
+		const Collider* col = colliders[handles[1]];
+		if (pos == nullptr || col == nullptr)
+			continue;
+
+		const EntityId entity = it.entity();
+		Proxy* p;
+		if (entity.index < entity_proxies.size() && entity_proxies[entity.index] != null_proxy
+			&& proxies[entity_proxies[entity.index]].entity == entity) {
+			p = &proxies[entity_proxies[entity.index]];
+		} else {
+			proxies.push_back(Proxy());
+			p = &proxies.back();
+			p->entity = entity;
+			++num_appended;
+		}
+		p->min_x = pos->position[0] + col->min[0];
+		p->max_x = pos->position[0] + col->max[0];
+		p->min_y = pos->position[1] + col->min[1];
+		p->max_y = pos->position[1] + col->max[1];
+		p->stamp = stamp;
+	}
+
+	// Drop entities that lost their components, were disabled or destroyed
+	const uint32_t current = stamp;
+	proxies.erase(std::remove_if(proxies.begin(), proxies.end(), [current](const Proxy& p) {
+		return p.stamp != current;
+	}), proxies.end());
+
+	sort_proxies(num_appended);
+
+	entity_proxies.assign(entity_proxies.size(), uint32_t(null_proxy));
+	for (size_t i = 0; i < proxies.size(); ++i) {
+		const size_t index = proxies[i].entity.index;
+		if (index >= entity_proxies.size()) {
+			entity_proxies.resize(index + 1, uint32_t(null_proxy));
+		}
+		entity_proxies[index] = static_cast<uint32_t>(i);
+	}
+
+	find_pairs();
+}
+
+void CollisionSystem::sort_proxies(size_t num_appended) {
+	auto by_min_x = [](const Proxy& a, const Proxy& b) {
+		return a.min_x < b.min_x;
+	};
+
+	// New boxes can land anywhere, so a large batch of them is cheaper to sort from scratch
+	if (num_appended > 64 + proxies.size() / 16) {
+		std::sort(proxies.begin(), proxies.end(), by_min_x);
+		return;
+	}
+
+	for (size_t i = 1; i < proxies.size(); ++i) {
+		if (!by_min_x(proxies[i], proxies[i - 1]))
+			continue;
+
+		const Proxy p = proxies[i];
+		size_t j = i;
+		do {
+			proxies[j] = proxies[j - 1];
+			--j;
+		} while (j > 0 && by_min_x(p, proxies[j - 1]));
+		proxies[j] = p;
+	}
+}
+
+void CollisionSystem::find_pairs() {
+	contacts.clear();
+
+	const size_t n = proxies.size();
+	const float inf = std::numeric_limits<float>::infinity();
+	// Padding never overlaps anything and stops the sweep at the end
+	sweep_min_x.assign(n + 4, inf);
+	sweep_min_y.assign(n + 4, inf);
+	sweep_max_y.assign(n + 4, -inf);
+	for (size_t i = 0; i < n; ++i) {
+		sweep_min_x[i] = proxies[i].min_x;
+		sweep_min_y[i] = proxies[i].min_y;
+		sweep_max_y[i] = proxies[i].max_y;
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		const Proxy& p = proxies[i];
+
+		// Boxes after i start right of p.min_x, so they overlap on x until one starts past p.max_x
+#ifdef COLLISION_USE_SSE
+		const __m128 max_x = _mm_set1_ps(p.max_x);
+		const __m128 min_y = _mm_set1_ps(p.min_y);
+		const __m128 max_y = _mm_set1_ps(p.max_y);
+		for (size_t j = i + 1;; j += 4) {
+			const __m128 overlap_x = _mm_cmple_ps(_mm_loadu_ps(&sweep_min_x[j]), max_x);
+			const __m128 overlap_y = _mm_and_ps(
+				_mm_cmple_ps(_mm_loadu_ps(&sweep_min_y[j]), max_y),
+				_mm_cmpge_ps(_mm_loadu_ps(&sweep_max_y[j]), min_y));
+
+			unsigned int hits = _mm_movemask_ps(_mm_and_ps(overlap_x, overlap_y));
+			while (hits != 0) {
+				add_contact(p, proxies[j + yks::countTrailingZeros(hits)]);
+				hits &= hits - 1;
+			}
+			if (_mm_movemask_ps(overlap_x) != 0xF)
+				break;
+		}
+#else
+		for (size_t j = i + 1; sweep_min_x[j] <= p.max_x; ++j) {
+			if (sweep_min_y[j] <= p.max_y && sweep_max_y[j] >= p.min_y) {
+				add_contact(p, proxies[j]);
+			}
+		}
+#endif
+	}
+}
+
+void CollisionSystem::add_contact(const Proxy& p, const Proxy& q) {
+	const Proxy& a = q.entity < p.entity ? q : p;
+	const Proxy& b = q.entity < p.entity ? p : q;
+
+	const float overlap_x = std::min(a.max_x, b.max_x) - std::max(a.min_x, b.min_x);
+	const float overlap_y = std::min(a.max_y, b.max_y) - std::max(a.min_y, b.min_y);
+	// Twice the distance between centers is enough to pick a direction
+	const float dx = (b.min_x + b.max_x) - (a.min_x + a.max_x);
+	const float dy = (b.min_y + b.max_y) - (a.min_y + a.max_y);
+
+	Contact c;
+	c.a = a.entity;
+	c.b = b.entity;
+	if (overlap_x < overlap_y) {
+		c.normal = yks::mvec2(dx < 0 ? -1.0f : 1.0f, 0.0f);
+		c.depth = overlap_x;
+	} else {
+		c.normal = yks::mvec2(0.0f, dy < 0 ? -1.0f : 1.0f);
+		c.depth = overlap_y;
+	}
+	contacts.push_back(c);
+}
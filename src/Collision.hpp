@@ -0,0 +1,62 @@
+#pragma once
+#include "EntitySystem.hpp"
+#include "GameComponents.hpp"
+#include "math/vec.hpp"
+#include "memory/ObjectPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** A pair of entities whose colliders overlap. */
+struct Contact {
+	EntityId a, b; // a < b
+	// Axis of least penetration, pointing from a towards b
+	yks::vec2 normal;
+	// Distance b has to move along normal to stop overlapping. Zero for boxes that only touch.
+	float depth;
+};
+
+/** Finds overlapping Colliders with sweep and prune along the x axis.
+ *
+ * Boxes are kept sorted by their left edge between updates. Things only
+ * move a little each frame, so insertion sort puts them back in order in
+ * close to linear time. The sweep then only pairs up boxes whose x ranges
+ * overlap and tests their y ranges four at a time. */
+struct CollisionSystem {
+	// Overlapping pairs found by the last update
+	std::vector<Contact> contacts;
+
+	CollisionSystem();
+
+	/** Updates the boxes of every enabled entity that has both a Position
+	 * and a Collider, then regenerates contacts. */
+	void update(EntityWorld& world, const yks::ObjectPool<Position>& positions, const yks::ObjectPool<Collider>& colliders);
+
+	/** Number of boxes being tracked. */
+	size_t size() const {
+		return proxies.size();
+	}
+
+	void clear();
+
+private:
+	struct Proxy {
+		float min_x, max_x, min_y, max_y;
+		EntityId entity;
+		uint32_t stamp; // Last update that saw the entity
+	};
+
+	static const uint32_t null_proxy = UINT32_MAX;
+
+	std::vector<Proxy> proxies; // Sorted by min_x after each update
+	std::vector<uint32_t> entity_proxies; // Index into proxies, indexed by roster index
+	uint32_t stamp;
+
+	// Copied out of proxies in sorted order for the sweep, padded so it can read past the end.
+	std::vector<float> sweep_min_x, sweep_min_y, sweep_max_y;
+
+	/** Re-sorts proxies. The last num_appended ones were just added. */
+	void sort_proxies(size_t num_appended);
+	void find_pairs();
+	void add_contact(const Proxy& p, const Proxy& q);
+};
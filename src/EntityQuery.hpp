@@ -1,16 +1,27 @@
 #pragma once
 #include "EntitySystem.hpp"
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include "index_tuple.hpp"
+#include "memory/SharedObjectPool.hpp"
+#include <vector>
 
+/** Iterates entities having all of the given component types. Terms are
+ * joined starting from the smallest component map, which drives iteration
+ * while the other maps are seeked forward to each candidate entity. */
 template <size_t num_types>
 struct EntityQueryIter {
 	static_assert(num_types >= 1, "Need to query at least one type.");
 
+	typedef EntityWorld::EntityComponentMap::const_iterator MapIter;
+
 	EntityWorld* world;
-	std::array<EntityWorld::EntityComponentMap::const_iterator, num_types> iters;
-	std::array<EntityWorld::EntityComponentMap::const_iterator, num_types> end_iters;
+	// Indexed in join order. order[i] maps back to the position in the query.
+	std::array<MapIter, num_types> iters;
+	std::array<MapIter, num_types> end_iters;
+	std::array<size_t, num_types> order;
 
 	EntityQueryIter()
 		: world(nullptr)
@@ -19,8 +30,10 @@ struct EntityQueryIter {
 	EntityQueryIter(EntityWorld* world, const std::array<ComponentTypeId, num_types>& types)
 		: world(world)
 	{
+		const QueryPlan& plan = world->getQueryPlan(types.data(), num_types);
 		for (size_t i = 0; i < num_types; ++i) {
-			auto& x = world->components_by_component_type[types[i]];
+			order[i] = plan.order[i];
+			auto& x = world->components_by_component_type[types[order[i]]];
 			iters[i] = x.data.cbegin();
 			end_iters[i] = x.data.cend();
 			if (iters[i] == end_iters[i]) {
@@ -50,28 +63,65 @@ struct EntityQueryIter {
 		world = nullptr;
 	}
 
+	/** Returns the first position in [it, end) with an id not less than id. */
+	static MapIter seek(MapIter it, MapIter end, EntityId id) {
+		if (it == end || !(std::get<0>(*it) < id)) {
+			return it;
+		}
+
+		// Gallop forward to bracket the target, then binary search the last step
+		ptrdiff_t step = 1;
+		while (step < end - it && std::get<0>(it[step]) < id) {
+			it += step;
+			step *= 2;
+		}
+		MapIter hi = step < end - it ? it + step : end;
+		return std::lower_bound(it + 1, hi, id, [](const EntityWorld::EntityComponentMap::Storage::value_type& v, EntityId k) {
+			return std::get<0>(v) < k;
+		});
+	}
+
 	void skip_non_matching() {
 		assert(world != nullptr);
 
-		bool advanced;
-		do {
-			EntityId max_id = std::get<0>(*iters[0]);
-			for (size_t i = 1; i < num_types; ++i) {
-				max_id = std::max(max_id, std::get<0>(*iters[i]));
+		size_t i = 1;
+		EntityId target = std::get<0>(*iters[0]);
+		for (;;) {
+			if (!world->isEntityEnabled(target)) {
+				// Jump past the run of disabled entities
+				iters[0] = seek(iters[0], end_iters[0], EntityId(world->findEnabledEntity(target.index + 1), 0));
+				if (iters[0] == end_iters[0]) {
+					invalidate();
+					return;
+				}
+				target = std::get<0>(*iters[0]);
+				i = 1;
+				continue;
 			}
 
-			advanced = false;
-			for (size_t i = 0; i < num_types; ++i) {
-				while (std::get<0>(*iters[i]) < max_id) {
-					advanced = true;
-					++iters[i];
-					if (iters[i] == end_iters[i]) {
-						invalidate();
-						return;
-					}
+			if (i == num_types) {
+				return;
+			}
+
+			iters[i] = seek(iters[i], end_iters[i], target);
+			if (iters[i] == end_iters[i]) {
+				invalidate();
+				return;
+			}
+
+			if (target < std::get<0>(*iters[i])) {
+				// Term doesn't have this entity, move the driver up to the one it does have
+				iters[0] = seek(iters[0], end_iters[0], std::get<0>(*iters[i]));
+				if (iters[0] == end_iters[0]) {
+					invalidate();
+					return;
 				}
+				target = std::get<0>(*iters[0]);
+				i = 1;
+			} else {
+				++i;
 			}
-		} while (advanced);
+		}
 	}
 
 	EntityQueryIter& operator++() {
@@ -80,10 +130,11 @@ struct EntityQueryIter {
 		for (size_t i = 0; i < num_types; ++i) {
 			if (++iters[i] == end_iters[i]) {
 				invalidate();
-				break;
+				return *this;
 			}
 		}
 
+		skip_non_matching();
 		return *this;
 	}
 
@@ -91,10 +142,16 @@ struct EntityQueryIter {
 		assert(world != nullptr);
 		std::array<ComponentHandle, num_types> ret;
 		for (size_t i = 0; i < num_types; ++i) {
-			ret[i] = std::get<1>(*iters[i]);
+			ret[order[i]] = std::get<1>(*iters[i]);
 		}
 		return ret;
 	}
+
+	/** The entity the current handles belong to. */
+	EntityId entity() const {
+		assert(world != nullptr);
+		return std::get<0>(*iters[0]);
+	}
 };
 
 /** Helper to allow using range-for on a query. */
@@ -124,14 +181,89 @@ EntityQuery<1 + sizeof...(Tail)> query(EntityWorld& world, T head, Tail... tail)
 	return EntityQuery<1 + sizeof...(Tail)>(&world, a);
 }
 
-template <typename Fn, typename Tup, size_t... i>
-void query_for_each_impl(const Tup& pools, const Fn& fn, const std::array<ComponentHandle, sizeof...(i)>& handles, index_tuple<i...>) {
-	fn(*(std::get<i>(pools)[std::get<i>(handles)])...);
+/** Number of entities whose component handles are resolved together. */
+static const size_t query_batch_size = 64;
+
+/** A block of query results. Handles are resolved one component at a time
+ * across the whole block, so the pools can prefetch ahead. */
+template <typename... Comp>
+struct QueryBatch {
+	std::array<std::array<ComponentHandle, query_batch_size>, sizeof...(Comp)> handles;
+	std::tuple<std::array<Comp*, query_batch_size>...> objects;
+	size_t size;
+
+	QueryBatch()
+		: size(0)
+	{}
+
+	template <typename... Pool, size_t... i>
+	void resolve(const std::tuple<Pool&...>& pools, index_tuple<i...>) {
+		int expand[] = { 0, (std::get<i>(pools).resolve_many(handles[i].data(), size, std::get<i>(objects).data()), 0)... };
+		(void)expand;
+	}
+
+	template <typename Fn, size_t... i, typename... Prefix>
+	void call(const Fn& fn, size_t row, index_tuple<i...>, const Prefix&... prefix) const {
+		fn(prefix..., *std::get<i>(objects)[row]...);
+	}
+};
+
+/** Calls fn with references to the components of every entity that has all of them.
+ * Pools are ObjectPools of the component types, with any Storage.
+ * fn must not add or remove entities, components, or objects in the queried pools. */
+template <typename Fn, typename... Pool>
+void query_for_each(EntityWorld& world, const std::tuple<Pool&...>& pools, const Fn& fn) {
+	QueryBatch<typename Pool::value_type...> batch;
+	auto flush = [&]() {
+		batch.resolve(pools, typename make_indexes<Pool...>::type());
+		for (size_t r = 0; r < batch.size; ++r) {
+			batch.call(fn, r, typename make_indexes<Pool...>::type());
+		}
+		batch.size = 0;
+	};
+
+	for (auto handles : query(world, Pool::value_type::component_id...)) {
+		for (size_t i = 0; i < sizeof...(Pool); ++i) {
+			batch.handles[i][batch.size] = handles[i];
+		}
+		if (++batch.size == query_batch_size) {
+			flush();
+		}
+	}
+	flush();
 }
 
-template <typename Fn, typename... Comp>
-void query_for_each(EntityWorld& world, const std::tuple<yks::ObjectPool<Comp>&...>& pools, const Fn& fn) {
-	for (auto handles : query(world, Comp::component_id...)) {
-		query_for_each_impl(pools, fn, handles, make_indexes<Comp...>::type());
+/** Like query_for_each, but the first component is a shared one. Entities
+ * are visited grouped by shared instance, which is only fetched once per group. */
+template <typename Fn, typename Shared, typename... Pool>
+void query_for_each_shared(EntityWorld& world, const yks::SharedObjectPool<Shared>& shared_pool, const std::tuple<Pool&...>& pools, const Fn& fn) {
+	typedef std::array<ComponentHandle, 1 + sizeof...(Pool)> Row;
+
+	std::vector<Row, yks::ResourceAllocator<Row>> rows(world.scratch_arena);
+	for (auto handles : query(world, Shared::component_id, Pool::value_type::component_id...)) {
+		rows.push_back(handles);
+	}
+	std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+		return a[0] < b[0];
+	});
+
+	QueryBatch<typename Pool::value_type...> batch;
+	const Shared* shared = nullptr;
+	for (size_t first = 0; first < rows.size(); first += query_batch_size) {
+		batch.size = rows.size() - first < query_batch_size ? rows.size() - first : query_batch_size;
+		for (size_t r = 0; r < batch.size; ++r) {
+			for (size_t i = 0; i < sizeof...(Pool); ++i) {
+				batch.handles[i][r] = rows[first + r][i + 1];
+			}
+		}
+		batch.resolve(pools, typename make_indexes<Pool...>::type());
+
+		for (size_t r = 0; r < batch.size; ++r) {
+			const size_t row = first + r;
+			if (row == 0 || rows[row][0] != rows[row - 1][0]) {
+				shared = shared_pool[rows[row][0]];
+			}
+			batch.call(fn, r, typename make_indexes<Pool...>::type(), *shared);
+		}
 	}
 }
@@ -0,0 +1,107 @@
+#pragma once
+#include "EntitySystem.hpp"
+#include "index_tuple.hpp"
+#include "memory/ObjectPool.hpp"
+#include "noncopyable.hpp"
+#include <array>
+#include <cassert>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/** Recycles entities for things that are spawned and killed constantly,
+ * like projectiles. Despawned entities keep their components and are only
+ * disabled and parked, so respawning one just overwrites its component
+ * values and enables it again, without touching the component maps.
+ * Pools are ObjectPools of the component types, with any Storage. */
+template <typename... Pool>
+struct EntitySpawner {
+	typedef std::array<ComponentHandle, sizeof...(Pool)> Handles;
+
+	struct Parked {
+		EntityId entity;
+		Handles handles;
+	};
+
+	EntityWorld* world;
+	std::tuple<Pool&...> pools;
+	std::string name; // Given to newly created entities
+	std::vector<Parked> parked;
+
+	EntitySpawner(EntityWorld* world, const std::tuple<Pool&...>& pools, const std::string& name)
+		: world(world), pools(pools), name(name)
+	{}
+
+	/** Reuses a parked entity, or creates a new one if none is parked. Its
+	 * components are set to values. */
+	EntityId respawn(const typename Pool::value_type&... values) {
+		if (parked.empty()) {
+			const EntityId entity = world->createEntity(name);
+			add_components(entity, typename make_indexes<Pool...>::type(), values...);
+			return entity;
+		}
+
+		const Parked p = parked.back();
+		parked.pop_back();
+		assign_components(p.handles, typename make_indexes<Pool...>::type(), values...);
+		world->setEntityEnabled(p.entity, true);
+		return p.entity;
+	}
+
+	/** Disables entity and parks it for reuse, cancelling its pending timers.
+	 * It must have been spawned by this spawner and not be despawned already. */
+	void despawn(EntityId entity) {
+		Entity* e = world->entities[entity];
+		assert(e != nullptr);
+		// Parking an entity twice would later hand it out to two respawns
+		assert(world->isEntityEnabled(entity));
+
+		Parked p;
+		p.entity = entity;
+		const ComponentTypeId types[] = { Pool::value_type::component_id... };
+		for (size_t i = 0; i < sizeof...(Pool); ++i) {
+			auto c = e->components.lookup(types[i]);
+			assert(c != e->components.data.end());
+			p.handles[i] = std::get<1>(*c);
+		}
+
+		world->cancelEntityTimers(entity);
+		world->setEntityEnabled(entity, false);
+		parked.push_back(p);
+	}
+
+	size_t numParked() const {
+		return parked.size();
+	}
+
+	/** Destroys all parked entities along with their components. Entities
+	 * that are currently spawned are left alone. */
+	void clear() {
+		for (const Parked& p : parked) {
+			world->destroyEntity(p.entity);
+			remove_components(p.handles, typename make_indexes<Pool...>::type());
+		}
+		parked.clear();
+	}
+
+private:
+	template <size_t... i>
+	void add_components(EntityId entity, index_tuple<i...>, const typename Pool::value_type&... values) {
+		int expand[] = { 0, (world->addComponentToEntity(std::get<i>(pools), entity, values), 0)... };
+		(void)expand;
+	}
+
+	template <size_t... i>
+	void assign_components(const Handles& handles, index_tuple<i...>, const typename Pool::value_type&... values) {
+		int expand[] = { 0, (*std::get<i>(pools)[handles[i]] = values, 0)... };
+		(void)expand;
+	}
+
+	template <size_t... i>
+	void remove_components(const Handles& handles, index_tuple<i...>) {
+		int expand[] = { 0, (std::get<i>(pools).remove(handles[i]), 0)... };
+		(void)expand;
+	}
+
+	NONCOPYABLE(EntitySpawner);
+};
@@ -1,4 +1,6 @@
 #include "EntitySystem.hpp"
+#include "bits.hpp"
+#include <algorithm>
 #include <cassert>
 
 bool EntityWorld::typeExists(ComponentTypeId type) {
@@ -20,6 +22,55 @@ EntityId EntityWorld::createEntity(const std::string& name) {
 	return entities.emplace(name);
 }
 
+void EntityWorld::destroyEntity(EntityId entity) {
+	Entity* e = entities[entity];
+	if (e == nullptr)
+		return;
+
+	for (const auto& c : e->components.data) {
+		components_by_component_type[std::get<0>(c)].remove(entity);
+	}
+	setEntityEnabled(entity, true);
+	entities.remove(entity);
+}
+
+void EntityWorld::destroyEntities(const EntityId* to_destroy, size_t count) {
+	std::vector<std::tuple<ComponentTypeId, EntityId>> removals;
+	for (size_t i = 0; i < count; ++i) {
+		const Entity* e = entities[to_destroy[i]];
+		if (e == nullptr)
+			continue;
+
+		for (const auto& c : e->components.data) {
+			removals.push_back(std::make_tuple(std::get<0>(c), to_destroy[i]));
+		}
+	}
+	std::sort(removals.begin(), removals.end());
+
+	std::vector<EntityId> keys(removals.size());
+	for (size_t i = 0; i < removals.size(); ++i) {
+		keys[i] = std::get<1>(removals[i]);
+	}
+
+	size_t first = 0;
+	while (first < removals.size()) {
+		const ComponentTypeId type = std::get<0>(removals[first]);
+		size_t last = first;
+		while (last < removals.size() && std::get<0>(removals[last]) == type) {
+			++last;
+		}
+		components_by_component_type[type].remove_keys(&keys[first], last - first);
+		first = last;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		if (entities.isValid(to_destroy[i])) {
+			setEntityEnabled(to_destroy[i], true);
+			entities.remove(to_destroy[i]);
+		}
+	}
+}
+
 void EntityWorld::addComponentToEntity(EntityId entity, ComponentTypeId type, ComponentHandle handle) {
 	assert(typeExists(type));
 
@@ -27,9 +78,133 @@ void EntityWorld::addComponentToEntity(EntityId entity, ComponentTypeId type, Co
 	components_by_component_type[type].insert(std::make_tuple(entity, handle));
 }
 
+void EntityWorld::addComponentToEntities(ComponentTypeId type, const EntityId* to_add, const ComponentHandle* handles, size_t count) {
+	assert(typeExists(type));
+
+	std::vector<std::tuple<EntityId, ComponentHandle>> batch;
+	batch.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		entities[to_add[i]]->components.insert(std::make_tuple(type, handles[i]));
+		batch.push_back(std::make_tuple(to_add[i], handles[i]));
+	}
+	components_by_component_type[type].insert_range(batch.begin(), batch.end());
+}
+
 void EntityWorld::removeComponentFromEntity(EntityId entity, ComponentTypeId type) {
 	assert(typeExists(type));
 
 	entities[entity]->components.remove(type);
 	components_by_component_type[type].remove(entity);
 }
+
+ComponentHandle EntityWorld::findComponent(EntityId entity, ComponentTypeId type) {
+	assert(typeExists(type));
+
+	EntityComponentMap& map = components_by_component_type[type];
+	auto pos = map.lookup(entity);
+	return pos != map.data.end() ? std::get<1>(*pos) : ComponentHandle();
+}
+
+void EntityWorld::setEntityEnabled(EntityId entity, bool enabled) {
+	assert(entities.isValid(entity));
+
+	const size_t word = entity.index / 64;
+	const uint64_t bit = uint64_t(1) << (entity.index % 64);
+	if (enabled) {
+		if (word < disabled_entities.size()) {
+			disabled_entities[word] &= ~bit;
+		}
+	} else {
+		if (word >= disabled_entities.size()) {
+			disabled_entities.resize(word + 1);
+		}
+		disabled_entities[word] |= bit;
+	}
+}
+
+void EntityWorld::setEntitiesEnabled(const EntityId* entities, size_t count, bool enabled) {
+	for (size_t i = 0; i < count; ++i) {
+		setEntityEnabled(entities[i], enabled);
+	}
+}
+
+void EntityWorld::enableAllEntities() {
+	std::fill(disabled_entities.begin(), disabled_entities.end(), 0);
+}
+
+size_t EntityWorld::findEnabledEntity(size_t index) const {
+	size_t word = index / 64;
+	if (word >= disabled_entities.size()) {
+		return index;
+	}
+
+	// Mask out bits below index in the first word, then scan a word at a time
+	uint64_t enabled = ~disabled_entities[word] & (~uint64_t(0) << (index % 64));
+	while (enabled == 0) {
+		if (++word == disabled_entities.size()) {
+			return word * 64;
+		}
+		enabled = ~disabled_entities[word];
+	}
+	return word * 64 + yks::countTrailingZeros(enabled);
+}
+
+yks::MemoryUsage EntityWorld::getMemoryUsage() const {
+	yks::MemoryUsage usage = entities.getMemoryUsage();
+	for (const Entity& e : entities.pool) {
+		if (!e.components.data.is_inline()) {
+			usage.bytes += e.components.getMemoryUsage().bytes;
+		}
+		usage.bytes += e.name.capacity();
+	}
+	for (const EntityComponentMap& m : components_by_component_type) {
+		usage.bytes += m.getMemoryUsage().bytes;
+	}
+	usage.bytes += disabled_entities.capacity() * sizeof(uint64_t);
+	return usage;
+}
+
+static uint64_t hashQuerySignature(const ComponentTypeId* types, size_t num_types) {
+	// FNV-1a
+	uint64_t h = 14695981039346656037ull;
+	for (size_t i = 0; i < num_types; ++i) {
+		h = (h ^ types[i]) * 1099511628211ull;
+	}
+	return h;
+}
+
+static bool cardinalityShifted(size_t planned, size_t current) {
+	const size_t ratio = EntityWorld::query_replan_ratio;
+	return current > planned * ratio || planned > current * ratio;
+}
+
+const QueryPlan& EntityWorld::getQueryPlan(const ComponentTypeId* types, size_t num_types) {
+	const uint64_t signature = hashQuerySignature(types, num_types);
+
+	auto pos = query_plans.lookup(signature);
+	if (pos == query_plans.data.end()) {
+		pos = query_plans.insert(std::make_tuple(signature, QueryPlan()));
+	}
+	QueryPlan& plan = std::get<1>(*pos);
+
+	bool replan = plan.types.size() != num_types || !std::equal(types, types + num_types, plan.types.begin());
+	for (size_t i = 0; !replan && i < num_types; ++i) {
+		replan = cardinalityShifted(plan.cardinalities[i], components_by_component_type[types[i]].data.size());
+	}
+	if (!replan) {
+		return plan;
+	}
+
+	plan.types.assign(types, types + num_types);
+	plan.cardinalities.resize(num_types);
+	plan.order.resize(num_types);
+	for (size_t i = 0; i < num_types; ++i) {
+		plan.cardinalities[i] = components_by_component_type[types[i]].data.size();
+		plan.order[i] = i;
+	}
+	std::stable_sort(plan.order.begin(), plan.order.end(), [&](size_t a, size_t b) {
+		return plan.cardinalities[a] < plan.cardinalities[b];
+	});
+
+	return plan;
+}
@@ -1,7 +1,13 @@
 #pragma once
 #include "Handle.hpp"
+#include "IndexedSortedVector.hpp"
+#include "SmallVector.hpp"
 #include "SortedVector.hpp"
+#include "TimerWheel.hpp"
+#include "memory/FrameArena.hpp"
 #include "memory/ObjectPool.hpp"
+#include "memory/SharedObjectPool.hpp"
+#include <cassert>
 #include <cstdint>
 #include <string>
 #include <tuple>
@@ -22,8 +28,12 @@ typedef yks::Handle ComponentHandle;
 
 typedef yks::Handle EntityId;
 struct Entity {
+	// Most entities only have a few components, so they are stored inline.
+	static const size_t inline_components = 6;
+	typedef std::tuple<ComponentTypeId, ComponentHandle> ComponentEntry;
+
 	std::string name;
-	SortedVector<std::tuple<ComponentTypeId, ComponentHandle>> components;
+	SortedVector<ComponentEntry, TupleKey<ComponentEntry>, SmallVector<ComponentEntry, inline_components>> components;
 
 	Entity() {}
 	Entity(const std::string& name)
@@ -31,24 +41,113 @@ struct Entity {
 	{}
 };
 
+/** Component maps are searched by roster index, which is also what EntityId sorts by. */
+template <>
+struct SearchKey<EntityId> {
+	static uint32_t get(EntityId entity) {
+		assert(entity.index <= UINT32_MAX);
+		return static_cast<uint32_t>(entity.index);
+	}
+};
+
+/** Order in which a query joins its terms, smallest component map first. */
+struct QueryPlan {
+	std::vector<ComponentTypeId> types; // In the order given by the query
+	std::vector<size_t> order; // order[i] is the index into types of the i-th term to join
+	std::vector<size_t> cardinalities; // Map sizes the plan was made with, indexed like types
+};
+
 struct EntityWorld {
-	typedef SortedVector<std::tuple<EntityId, ComponentHandle>> EntityComponentMap;
+	typedef IndexedSortedVector<std::tuple<EntityId, ComponentHandle>> EntityComponentMap;
+	typedef SortedVector<std::tuple<uint64_t, QueryPlan>> QueryPlanCache;
+
+	/** A cached plan is redone once any of its map sizes grows or shrinks by this factor. */
+	static const size_t query_replan_ratio = 2;
 	
 	std::vector<ComponentType> component_types;
 	yks::ObjectPool<Entity> entities;
 	std::vector<EntityComponentMap> components_by_component_type;
+	TimerWheel timers;
+
+	// One bit per entity roster index. Set bits are disabled entities and
+	// get skipped by queries. Entities past the end are enabled.
+	std::vector<uint64_t> disabled_entities;
+
+	QueryPlanCache query_plans;
+
+	// If set, query helpers take their per-call scratch memory from here.
+	yks::FrameArena* scratch_arena;
+
+	EntityWorld()
+		: scratch_arena(nullptr)
+	{}
 
 	bool typeExists(ComponentTypeId type);
 
 	void addComponentType(ComponentTypeId id, const std::string& name);
 	EntityId createEntity(const std::string& name);
+	/** Removes the entity and its component entries. Component data stays in its pool. */
+	void destroyEntity(EntityId entity);
+	/** Destroys several entities at once, compacting each affected component map only once. */
+	void destroyEntities(const EntityId* entities, size_t count);
 	void addComponentToEntity(EntityId entity, ComponentTypeId type, ComponentHandle handle);
+	/** Adds handles[i] to entities[i] for each i, merging them into the component map in one pass. */
+	void addComponentToEntities(ComponentTypeId type, const EntityId* entities, const ComponentHandle* handles, size_t count);
 	void removeComponentFromEntity(EntityId entity, ComponentTypeId type);
+	/** Returns the handle of entity's component of the given type, or a null
+	 * handle. Looked up in the component map, without touching the entity. */
+	ComponentHandle findComponent(EntityId entity, ComponentTypeId type);
+
+	bool isEntityEnabled(EntityId entity) const {
+		const size_t word = entity.index / 64;
+		return word >= disabled_entities.size() || !(disabled_entities[word] & (uint64_t(1) << (entity.index % 64)));
+	}
+
+	void setEntityEnabled(EntityId entity, bool enabled);
+	void setEntitiesEnabled(const EntityId* entities, size_t count, bool enabled);
+	void enableAllEntities();
+
+	/** Returns the first enabled roster index >= index. */
+	size_t findEnabledEntity(size_t index) const;
+
+	/** Returns the join order for a query over types, reusing a cached plan
+	 * while the sizes of the involved component maps stay roughly the same. */
+	const QueryPlan& getQueryPlan(const ComponentTypeId* types, size_t num_types);
+
+	/** Entities and component maps. Component data is reported by its own pools. */
+	yks::MemoryUsage getMemoryUsage() const;
+
+	template <typename C, template <typename> class Storage, typename... Args>
+	yks::Handle addComponentToEntity(yks::ObjectPool<C, Storage>& pool, EntityId entity, Args&&... params) {
+		yks::Handle h = pool.emplace(std::forward<Args>(params)...);
+		addComponentToEntity(entity, C::component_id, h);
+		return h;
+	}
 
 	template <typename C, typename... Args>
-	yks::Handle addComponentToEntity(yks::ObjectPool<C>& pool, EntityId entity, Args&&... params) {
+	yks::Handle addComponentToEntity(yks::SharedObjectPool<C>& pool, EntityId entity, Args&&... params) {
 		yks::Handle h = pool.emplace(std::forward<Args>(params)...);
 		addComponentToEntity(entity, C::component_id, h);
 		return h;
 	}
+
+	TimerId scheduleTimer(EntityId entity, TimerEventId event, uint64_t delay_ticks) {
+		return timers.schedule(entity, event, delay_ticks);
+	}
+
+	/** Cancels all pending timers of entity, which otherwise outlive it being parked. */
+	void cancelEntityTimers(EntityId entity) {
+		timers.cancelOwner(entity);
+	}
+
+	/** Advances timers by one tick, calling fn(entity, event) for each one
+	 * that expired. Timers belonging to destroyed entities are dropped. */
+	template <typename Fn>
+	void advanceTimers(const Fn& fn) {
+		timers.advance([&](EntityId entity, TimerEventId event) {
+			if (entities.isValid(entity)) {
+				fn(entity, event);
+			}
+		});
+	}
 };
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+/** Fixed-capacity, double-buffered channel of events of a single type.
+ * Events published during a tick become readable after the next call to
+ * swap(). publish() may be called from several threads at once, while
+ * swap() and reading must happen when no one is publishing. */
+template <typename T, size_t capacity>
+struct EventChannel {
+	static_assert(std::is_trivially_copyable<T>::value, "Events must be trivially copyable");
+
+	typedef const T* const_iterator;
+
+	EventChannel()
+		: write_buffer(0), read_count(0), dropped_count(0)
+	{
+		write_count.store(0, std::memory_order_relaxed);
+	}
+
+	/** Returns false if the channel is full and the event got dropped. */
+	bool publish(const T& ev) {
+		const uint32_t i = write_count.fetch_add(1, std::memory_order_relaxed);
+		if (i >= capacity) {
+			return false;
+		}
+		buffers[write_buffer][i] = ev;
+		return true;
+	}
+
+	/** Makes events published since the last swap readable and starts a new tick. */
+	void swap() {
+		const uint32_t written = write_count.load(std::memory_order_acquire);
+		read_count = written < capacity ? written : capacity;
+		dropped_count = written - read_count;
+
+		write_buffer ^= 1;
+		write_count.store(0, std::memory_order_release);
+	}
+
+	const_iterator begin() const { return buffers[write_buffer ^ 1].data(); }
+	const_iterator end() const { return begin() + read_count; }
+	size_t size() const { return read_count; }
+	bool empty() const { return read_count == 0; }
+
+	/** Number of events dropped during the previous tick due to the channel being full. */
+	size_t dropped() const { return dropped_count; }
+
+private:
+	std::array<std::array<T, capacity>, 2> buffers;
+	std::atomic<uint32_t> write_count;
+	unsigned int write_buffer;
+	size_t read_count;
+	size_t dropped_count;
+};
+
+template <typename T, typename Tup>
+struct EventChannelIndex;
+
+template <typename T, size_t N, typename... Tail>
+struct EventChannelIndex<T, std::tuple<EventChannel<T, N>, Tail...>> {
+	static const size_t value = 0;
+};
+
+template <typename T, typename Head, typename... Tail>
+struct EventChannelIndex<T, std::tuple<Head, Tail...>> {
+	static const size_t value = 1 + EventChannelIndex<T, std::tuple<Tail...>>::value;
+};
+
+/** A set of event channels, looked up by event type at compile time. */
+template <typename... Channels>
+struct EventBus {
+	typedef std::tuple<Channels...> ChannelTuple;
+	ChannelTuple channels;
+
+	template <typename T>
+	typename std::tuple_element<EventChannelIndex<T, ChannelTuple>::value, ChannelTuple>::type& get() {
+		return std::get<EventChannelIndex<T, ChannelTuple>::value>(channels);
+	}
+
+	template <typename T>
+	bool publish(const T& ev) {
+		return get<T>().publish(ev);
+	}
+
+	/** Flips every channel. Call once per tick, between systems runs. */
+	void swap() {
+		swap_impl(std::integral_constant<size_t, 0>());
+	}
+
+private:
+	void swap_impl(std::integral_constant<size_t, sizeof...(Channels)>) {}
+
+	template <size_t i>
+	void swap_impl(std::integral_constant<size_t, i>) {
+		std::get<i>(channels).swap();
+		swap_impl(std::integral_constant<size_t, i + 1>());
+	}
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include "EntitySystem.hpp"
+#include "math/vec.hpp"
+#include "render/Sprite.hpp"
+#include <tuple>
+
+struct Position  {
+	static const ComponentTypeId component_id = 0;
+
+	yks::vec2 position;
+
+	Position(yks::vec2 position)
+		: position(position)
+	{}
+};
+
+struct Velocity {
+	static const ComponentTypeId component_id = 1;
+
+	yks::vec2 velocity;
+
+	Velocity(yks::vec2 velocity)
+		: velocity(velocity)
+	{}
+};
+
+struct SpriteRenderer {
+	static const ComponentTypeId component_id = 2;
+
+	int layer;
+	yks::IntRect img_rect;
+
+	SpriteRenderer(int layer, yks::IntRect img_rect)
+		: layer(layer), img_rect(img_rect)
+	{}
+
+	bool operator==(const SpriteRenderer& o) const {
+		return std::tie(layer, img_rect.x, img_rect.y, img_rect.w, img_rect.h)
+			== std::tie(o.layer, o.img_rect.x, o.img_rect.y, o.img_rect.w, o.img_rect.h);
+	}
+
+	bool operator<(const SpriteRenderer& o) const {
+		return std::tie(layer, img_rect.x, img_rect.y, img_rect.w, img_rect.h)
+			< std::tie(o.layer, o.img_rect.x, o.img_rect.y, o.img_rect.w, o.img_rect.h);
+	}
+};
+
+struct Gravity {
+	static const ComponentTypeId component_id = 3;
+
+	yks::vec2 acceleration;
+
+	Gravity(yks::vec2 acceleration)
+		: acceleration(acceleration)
+	{}
+};
+
+struct Collider {
+	static const ComponentTypeId component_id = 4;
+
+	// Corners of the box, relative to the entity's Position
+	yks::vec2 min;
+	yks::vec2 max;
+
+	Collider(yks::vec2 min, yks::vec2 max)
+		: min(min), max(max)
+	{}
+};
@@ -0,0 +1,30 @@
+#include "GameWorld.hpp"
+#include "EntityQuery.hpp"
+
+GameWorld::GameWorld(uint32_t seed)
+	: rng(seed), tick(0)
+{
+	world.addComponentType(Position::component_id, "Position");
+	world.addComponentType(Velocity::component_id, "Velocity");
+	world.addComponentType(SpriteRenderer::component_id, "SpriteRenderer");
+	world.addComponentType(Gravity::component_id, "Gravity");
+	world.addComponentType(Collider::component_id, "Collider");
+
+	world.scratch_arena = &frame_arena;
+}
+
+void GameWorld::update() {
+	frame_arena.reset();
+
+	query_for_each(world, std::tie(velocityPool, gravityPool), [&](Velocity& vel, const Gravity& gravity) {
+		vel.velocity += gravity.acceleration;
+	});
+
+	query_for_each(world, std::tie(positionPool, velocityPool), [&](Position& pos, const Velocity& vel) {
+		pos.position += vel.velocity;
+	});
+
+	spatial_hash.update(world, positionPool);
+	collisions.update(world, positionPool, colliderPool);
+	++tick;
+}
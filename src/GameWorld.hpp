@@ -0,0 +1,41 @@
+#pragma once
+#include "Collision.hpp"
+#include "EntitySystem.hpp"
+#include "GameComponents.hpp"
+#include "SpatialHash.hpp"
+#include "memory/FrameArena.hpp"
+#include "memory/ObjectPool.hpp"
+#include "memory/SharedObjectPool.hpp"
+#include "noncopyable.hpp"
+#include "util.hpp"
+#include <cstdint>
+
+/** A whole simulation: the entity world, the pools holding its components
+ * and its random generator. Worlds share no state with each other, so
+ * several can be stepped at once on different threads. */
+struct GameWorld {
+	EntityWorld world;
+	yks::ObjectPool<Position> positionPool;
+	yks::ObjectPool<Velocity> velocityPool;
+	yks::SharedObjectPool<SpriteRenderer> spriteRendererPool;
+	yks::ObjectPool<Gravity> gravityPool;
+	yks::ObjectPool<Collider> colliderPool;
+
+	// Positions of all entities, brought up to date every update.
+	SpatialHash spatial_hash;
+	// Contacts between Colliders after this tick's movement.
+	CollisionSystem collisions;
+
+	yks::FrameArena frame_arena;
+	// Only source of randomness for the simulation, so a seed fully determines a run.
+	RandomGenerator rng;
+	uint64_t tick;
+
+	explicit GameWorld(uint32_t seed = 0);
+
+	/** Advances the simulation by one tick. Scratch memory from the previous
+	 * tick is released first. */
+	void update();
+
+	NONCOPYABLE(GameWorld);
+};
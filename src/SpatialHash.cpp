@@ -0,0 +1,419 @@
+#include "SpatialHash.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cell_size)
+	: cell_size(cell_size), inv_cell_size(1.0f / cell_size), num_removed(0), bucket_mask(0), num_live(0), stamp(0)
+{
+	bucket_start.assign(2, 0);
+}
+
+void SpatialHash::clear() {
+	entries.clear();
+	entry_buckets.clear();
+	entry_sorted.clear();
+	num_removed = 0;
+	entity_slots.clear();
+	sorted_slots.clear();
+	unsorted_slots.clear();
+	stale_buckets.clear();
+	bucket_mask = 0;
+	bucket_start.assign(2, 0);
+	num_live = 0;
+}
+
+uint32_t SpatialHash::bucketCountFor(size_t count) {
+	// About two entries per bucket keeps the table small enough to stay in cache
+	uint32_t num_buckets = 16;
+	while (num_buckets < count / 2) {
+		num_buckets *= 2;
+	}
+	return num_buckets;
+}
+
+void SpatialHash::set_position(uint32_t slot, yks::vec2 position) {
+	Entry& e = entries[slot];
+	e.position = position;
+	e.cell_x = static_cast<int32_t>(std::floor(position[0] * inv_cell_size));
+	e.cell_y = static_cast<int32_t>(std::floor(position[1] * inv_cell_size));
+	entry_buckets[slot] = bucket_of(e.cell_x, e.cell_y);
+}
+
+uint32_t SpatialHash::bucket_of(int32_t cell_x, int32_t cell_y) const {
+	const uint32_t h = static_cast<uint32_t>(cell_x) * 73856093u ^ static_cast<uint32_t>(cell_y) * 19349663u;
+	return (h ^ (h >> 16)) & bucket_mask;
+}
+
+void SpatialHash::rebuild(const EntityWorld& world, const yks::ObjectPool<Position>& positions) {
+	const auto& map = world.components_by_component_type[Position::component_id].data;
+	const size_t count = map.size();
+
+	entries.resize(count);
+	entry_buckets.resize(count);
+	entry_sorted.resize(count);
+	entity_slots.assign(count > 0 ? std::get<0>(map.back()).index + 1 : 0, uint32_t(null_slot));
+	bucket_mask = bucketCountFor(count) - 1;
+
+	// Reading positions through their handles is the expensive part, so spread it out
+	chunk_removed.resize(count / 4096 + 1);
+	yks::parallel_for(count, 4096, [&](size_t begin, size_t end) {
+		size_t removed = 0;
+		for (size_t i = begin; i < end; ++i) {
+			const EntityId entity = std::get<0>(map[i]);
+			const Position* pos = positions[std::get<1>(map[i])];
+			if (pos == nullptr || !world.isEntityEnabled(entity)) {
+				entries[i].entity = EntityId();
+				++removed;
+				continue;
+			}
+			entries[i].entity = entity;
+			entries[i].stamp = stamp;
+			set_position(static_cast<uint32_t>(i), pos->position);
+			entity_slots[entity.index] = static_cast<uint32_t>(i);
+		}
+		chunk_removed[begin / 4096] = removed;
+	});
+
+	num_removed = 0;
+	for (size_t n : chunk_removed) {
+		num_removed += n;
+	}
+	sort_entries();
+}
+
+void SpatialHash::update(const EntityWorld& world, const yks::ObjectPool<Position>& positions) {
+	if (num_live == 0) {
+		// Nothing to keep, so sorting everything at once is cheapest
+		rebuild(world, positions);
+		return;
+	}
+
+	const auto& map = world.components_by_component_type[Position::component_id].data;
+	const size_t count = map.size();
+	const uint32_t current = ++stamp;
+
+	// Every row only touches the entry of its own entity, so chunks can't conflict
+	chunk_counts.resize(count / 4096 + 1);
+	chunk_moves.resize(chunk_counts.size());
+	for (std::vector<Move>& moves : chunk_moves) {
+		moves.clear();
+	}
+	yks::parallel_for(count, 4096, [&](size_t begin, size_t end) {
+		Counts counts = {};
+		std::vector<Move>& moves = chunk_moves[begin / 4096];
+		for (size_t i = begin; i < end; ++i) {
+			const EntityId entity = std::get<0>(map[i]);
+			const Position* pos = positions[std::get<1>(map[i])];
+			if (pos == nullptr || !world.isEntityEnabled(entity))
+				continue;
+			if (!contains(entity)) {
+				++counts.missing;
+				continue;
+			}
+
+			const uint32_t slot = entity_slots[entity.index];
+			Entry& e = entries[slot];
+			e.stamp = current;
+			++counts.seen;
+			if (e.position[0] == pos->position[0] && e.position[1] == pos->position[1])
+				continue;
+
+			const uint32_t old_bucket = entry_buckets[slot];
+			set_position(slot, pos->position);
+			if (entry_buckets[slot] != old_bucket && entry_sorted[slot]) {
+				entry_sorted[slot] = 0;
+				if (++counts.moved <= (end - begin) / 16) {
+					const Move m = { slot, old_bucket };
+					moves.push_back(m);
+				}
+			}
+		}
+		chunk_counts[begin / 4096] = counts;
+	});
+
+	Counts total = {};
+	bool all_listed = true;
+	for (size_t i = 0; i < chunk_counts.size(); ++i) {
+		total.seen += chunk_counts[i].seen;
+		total.missing += chunk_counts[i].missing;
+		total.moved += chunk_counts[i].moved;
+		all_listed = all_listed && chunk_counts[i].moved == chunk_moves[i].size();
+	}
+
+	// Entries that weren't seen lost their Position, or were disabled or destroyed
+	if (total.seen != num_live) {
+		for (size_t slot = 0; slot < entries.size(); ++slot) {
+			if (!entries[slot].entity.isNull() && entries[slot].stamp != current) {
+				remove(entries[slot].entity);
+			}
+		}
+	}
+	if (total.missing > 0) {
+		for (size_t i = 0; i < count; ++i) {
+			const EntityId entity = std::get<0>(map[i]);
+			const Position* pos = positions[std::get<1>(map[i])];
+			if (pos != nullptr && world.isEntityEnabled(entity) && !contains(entity)) {
+				add_entry(entity, pos->position);
+			}
+		}
+	}
+
+	// Merging sorts the changed entries, past some point sorting everything is cheaper
+	const size_t changes = unsorted_slots.size() + total.moved;
+	if (!all_listed || changes > entries.size() / 16 || num_removed > entries.size() / 4 || bucket_mask + 1 < bucketCountFor(num_live)) {
+		sort_entries();
+	} else if (changes > 0) {
+		for (const std::vector<Move>& moves : chunk_moves) {
+			for (const Move& m : moves) {
+				unsorted_slots.push_back(m.slot);
+				stale_buckets.push_back(m.old_bucket);
+			}
+		}
+		merge_moved();
+	}
+}
+
+void SpatialHash::sort_entries() {
+	if (num_removed > 0) {
+		size_t live = 0;
+		for (size_t i = 0; i < entries.size(); ++i) {
+			if (entries[i].entity.isNull())
+				continue;
+			if (live != i) {
+				entries[live] = entries[i];
+				entry_buckets[live] = entry_buckets[i];
+				entity_slots[entries[live].entity.index] = static_cast<uint32_t>(live);
+			}
+			++live;
+		}
+		entries.resize(live);
+		entry_buckets.resize(live);
+		entry_sorted.resize(live);
+		num_removed = 0;
+	}
+	num_live = entries.size();
+
+	// Grow the table along with the entity count
+	if (bucket_mask + 1 < bucketCountFor(num_live)) {
+		bucket_mask = bucketCountFor(num_live) - 1;
+		for (size_t i = 0; i < entries.size(); ++i) {
+			entry_buckets[i] = bucket_of(entries[i].cell_x, entries[i].cell_y);
+		}
+	}
+
+	// Counting sort by bucket. Scattering bumps each bucket's start up to the
+	// next one's, so shifting the array by one afterwards restores the starts.
+	bucket_start.assign(bucket_mask + 2, 0);
+	for (uint32_t b : entry_buckets) {
+		++bucket_start[b + 1];
+	}
+	for (size_t b = 1; b < bucket_start.size(); ++b) {
+		bucket_start[b] += bucket_start[b - 1];
+	}
+	sorted_slots.resize(entries.size());
+	for (size_t i = 0; i < entry_buckets.size(); ++i) {
+		sorted_slots[bucket_start[entry_buckets[i]]++] = static_cast<uint32_t>(i);
+	}
+	std::copy_backward(bucket_start.begin(), bucket_start.end() - 1, bucket_start.end());
+	bucket_start[0] = 0;
+
+	std::fill(entry_sorted.begin(), entry_sorted.end(), 1);
+	unsorted_slots.clear();
+	stale_buckets.clear();
+}
+
+void SpatialHash::maybe_sort() {
+	if (unsorted_slots.size() > 64 + entries.size() / 4) {
+		sort_entries();
+	}
+}
+
+void SpatialHash::merge_moved() {
+	// Entries to put in, ordered by bucket
+	merge_keys.clear();
+	for (uint32_t slot : unsorted_slots) {
+		if (!entries[slot].entity.isNull()) {
+			merge_keys.push_back(uint64_t(entry_buckets[slot]) << 32 | slot);
+		}
+	}
+	std::sort(merge_keys.begin(), merge_keys.end());
+	std::sort(stale_buckets.begin(), stale_buckets.end());
+
+	// Only buckets that gain or lose entries are rewritten. The runs of
+	// sorted_slots between them are copied as they are, and their starts
+	// shifted by how much the buckets before grew or shrank.
+	merge_slots.resize(num_live);
+	uint32_t out = 0;
+	uint32_t copied = 0; // Old position copied up to
+	uint32_t shifted = 0; // First bucket whose start is still the old one
+	size_t next_key = 0;
+	size_t next_stale = 0;
+	for (;;) {
+		const uint32_t key_bucket = next_key < merge_keys.size() ? uint32_t(merge_keys[next_key] >> 32) : UINT32_MAX;
+		const uint32_t stale_bucket = next_stale < stale_buckets.size() ? stale_buckets[next_stale] : UINT32_MAX;
+		const uint32_t b = std::min(key_bucket, stale_bucket);
+		const uint32_t first = b == UINT32_MAX ? bucket_start[bucket_mask + 1] : bucket_start[b];
+
+		// Unsigned wraparound makes this work for shrinking too
+		const uint32_t offset = out - copied;
+		std::copy(sorted_slots.begin() + copied, sorted_slots.begin() + first, merge_slots.begin() + out);
+		out += first - copied;
+		for (; shifted < b && shifted <= bucket_mask + 1; ++shifted) {
+			bucket_start[shifted] += offset;
+		}
+		if (b == UINT32_MAX)
+			break;
+
+		const uint32_t last = bucket_start[b + 1];
+		bucket_start[b] = out;
+		for (uint32_t i = first; i < last; ++i) {
+			const uint32_t slot = sorted_slots[i];
+			if (entry_sorted[slot]) {
+				merge_slots[out++] = slot;
+			}
+		}
+		for (; next_key < merge_keys.size() && uint32_t(merge_keys[next_key] >> 32) == b; ++next_key) {
+			merge_slots[out++] = uint32_t(merge_keys[next_key]);
+		}
+		for (; next_stale < stale_buckets.size() && stale_buckets[next_stale] == b; ++next_stale) {}
+		copied = last;
+		shifted = b + 1;
+	}
+	assert(out == num_live);
+
+	// Only now, as the old position of a moved entry may have been after its new one
+	for (uint64_t key : merge_keys) {
+		entry_sorted[uint32_t(key)] = 1;
+	}
+	sorted_slots.swap(merge_slots);
+	unsorted_slots.clear();
+	stale_buckets.clear();
+}
+
+void SpatialHash::insert(EntityId entity, yks::vec2 position) {
+	assert(!contains(entity));
+	add_entry(entity, position);
+	maybe_sort();
+}
+
+void SpatialHash::add_entry(EntityId entity, yks::vec2 position) {
+	if (entity_slots.size() <= entity.index) {
+		entity_slots.resize(entity.index + 1, uint32_t(null_slot));
+	}
+	const uint32_t slot = static_cast<uint32_t>(entries.size());
+	entity_slots[entity.index] = slot;
+
+	entries.push_back(Entry());
+	entry_buckets.push_back(0);
+	entry_sorted.push_back(0);
+	entries[slot].entity = entity;
+	entries[slot].stamp = stamp;
+	set_position(slot, position);
+	unsorted_slots.push_back(slot);
+	++num_live;
+}
+
+void SpatialHash::move(EntityId entity, yks::vec2 position) {
+	if (!contains(entity)) {
+		insert(entity, position);
+		return;
+	}
+
+	const uint32_t slot = entity_slots[entity.index];
+	const uint32_t old_bucket = entry_buckets[slot];
+	set_position(slot, position);
+	if (entry_buckets[slot] != old_bucket && entry_sorted[slot]) {
+		entry_sorted[slot] = 0;
+		unsorted_slots.push_back(slot);
+		stale_buckets.push_back(old_bucket);
+		maybe_sort();
+	}
+}
+
+void SpatialHash::remove(EntityId entity) {
+	if (!contains(entity))
+		return;
+
+	const uint32_t slot = entity_slots[entity.index];
+	if (entry_sorted[slot]) {
+		stale_buckets.push_back(entry_buckets[slot]);
+	}
+	entries[slot].entity = EntityId();
+	entry_sorted[slot] = 0;
+	entity_slots[entity.index] = null_slot;
+	++num_removed;
+	--num_live;
+}
+
+bool SpatialHash::contains(EntityId entity) const {
+	return entity.index < entity_slots.size() && entity_slots[entity.index] != null_slot
+		&& entries[entity_slots[entity.index]].entity == entity;
+}
+
+template <typename Fn>
+void SpatialHash::for_each_in_cells(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const Fn& fn) const {
+	// Entries are only reported from their own cell, so cells sharing a bucket don't produce duplicates
+	auto in_cells = [&](const Entry& e) {
+		return e.cell_x >= x0 && e.cell_x <= x1 && e.cell_y >= y0 && e.cell_y <= y1;
+	};
+
+	const uint64_t num_cells = uint64_t(int64_t(x1) - x0 + 1) * uint64_t(int64_t(y1) - y0 + 1);
+	if (num_cells > bucket_mask + 1) {
+		// Touches more cells than there are buckets, a plain scan is cheaper
+		for (const Entry& e : entries) {
+			if (!e.entity.isNull() && in_cells(e)) {
+				fn(e);
+			}
+		}
+		return;
+	}
+
+	for (int32_t y = y0; y <= y1; ++y) {
+		for (int32_t x = x0; x <= x1; ++x) {
+			const uint32_t b = bucket_of(x, y);
+			for (uint32_t i = bucket_start[b]; i < bucket_start[b + 1]; ++i) {
+				const uint32_t slot = sorted_slots[i];
+				const Entry& e = entries[slot];
+				if (entry_sorted[slot] && e.cell_x == x && e.cell_y == y) {
+					fn(e);
+				}
+			}
+		}
+	}
+	for (uint32_t slot : unsorted_slots) {
+		const Entry& e = entries[slot];
+		if (!e.entity.isNull() && !entry_sorted[slot] && in_cells(e)) {
+			fn(e);
+		}
+	}
+}
+
+void SpatialHash::queryRect(yks::vec2 min, yks::vec2 max, std::vector<EntityId>& out) const {
+	const int32_t x0 = static_cast<int32_t>(std::floor(min[0] * inv_cell_size));
+	const int32_t y0 = static_cast<int32_t>(std::floor(min[1] * inv_cell_size));
+	const int32_t x1 = static_cast<int32_t>(std::floor(max[0] * inv_cell_size));
+	const int32_t y1 = static_cast<int32_t>(std::floor(max[1] * inv_cell_size));
+
+	for_each_in_cells(x0, y0, x1, y1, [&](const Entry& e) {
+		if (e.position[0] >= min[0] && e.position[0] <= max[0] && e.position[1] >= min[1] && e.position[1] <= max[1]) {
+			out.push_back(e.entity);
+		}
+	});
+}
+
+void SpatialHash::queryRadius(yks::vec2 center, float radius, std::vector<EntityId>& out) const {
+	const float r2 = radius * radius;
+	const int32_t x0 = static_cast<int32_t>(std::floor((center[0] - radius) * inv_cell_size));
+	const int32_t y0 = static_cast<int32_t>(std::floor((center[1] - radius) * inv_cell_size));
+	const int32_t x1 = static_cast<int32_t>(std::floor((center[0] + radius) * inv_cell_size));
+	const int32_t y1 = static_cast<int32_t>(std::floor((center[1] + radius) * inv_cell_size));
+
+	for_each_in_cells(x0, y0, x1, y1, [&](const Entry& e) {
+		const float dx = e.position[0] - center[0];
+		const float dy = e.position[1] - center[1];
+		if (dx * dx + dy * dy <= r2) {
+			out.push_back(e.entity);
+		}
+	});
+}
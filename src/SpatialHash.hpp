@@ -0,0 +1,110 @@
+#pragma once
+#include "EntitySystem.hpp"
+#include "GameComponents.hpp"
+#include "math/vec.hpp"
+#include "memory/ObjectPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Broadphase index of entity positions on a uniform grid. Cells are hashed
+ * into a bucket table, so the world has no bounds. Entries are kept sorted by
+ * bucket, and single entities can be inserted, moved and removed between
+ * rebuilds. Those that changed bucket are kept in a small unsorted list that
+ * queries scan too, until it grows large enough to be sorted back in.
+ *
+ * To follow the Position components every frame, call update(), or
+ * rebuild() when most entities change cell anyway. Both read the positions
+ * in parallel on the default thread pool, or serially when called from
+ * inside a pool job, e.g. a BatchSimulator worker. */
+struct SpatialHash {
+	explicit SpatialHash(float cell_size = 64.0f);
+
+	/** Re-indexes every enabled entity that has a Position component. */
+	void rebuild(const EntityWorld& world, const yks::ObjectPool<Position>& positions);
+	/** Brings the index up to date with the Position components. Entries are
+	 * moved in place, and only those that changed bucket are merged into their
+	 * new one, which is much cheaper than rebuild() when most entities stay in
+	 * their cell. If too many changed, everything is sorted again instead.
+	 * Entities that gained or lost a Position, or were enabled or disabled,
+	 * are inserted or removed. */
+	void update(const EntityWorld& world, const yks::ObjectPool<Position>& positions);
+
+	void insert(EntityId entity, yks::vec2 position);
+	/** Updates the position of entity, inserting it if it isn't indexed. */
+	void move(EntityId entity, yks::vec2 position);
+	void remove(EntityId entity);
+	bool contains(EntityId entity) const;
+
+	/** Appends to out every entity with a position inside [min, max]. */
+	void queryRect(yks::vec2 min, yks::vec2 max, std::vector<EntityId>& out) const;
+	/** Appends to out every entity within radius of center. */
+	void queryRadius(yks::vec2 center, float radius, std::vector<EntityId>& out) const;
+
+	size_t size() const {
+		return num_live;
+	}
+
+	void clear();
+
+private:
+	struct Entry {
+		EntityId entity; // Null for removed entries
+		yks::vec2 position;
+		int32_t cell_x, cell_y;
+		uint32_t stamp; // Last update() that saw the entity
+	};
+
+	static const uint32_t null_slot = UINT32_MAX;
+
+	float cell_size;
+	float inv_cell_size;
+
+	// Indexed by slot. Bucket and sorted flag are kept apart, so sorting doesn't have to stream whole entries.
+	std::vector<Entry> entries;
+	std::vector<uint32_t> entry_buckets;
+	std::vector<uint8_t> entry_sorted; // Still at its place in sorted_slots
+	size_t num_removed;
+	std::vector<uint32_t> entity_slots; // Slot of each entity, indexed by roster index
+
+	uint32_t bucket_mask;
+	std::vector<uint32_t> bucket_start; // Range of each bucket in sorted_slots
+	std::vector<uint32_t> sorted_slots;
+	std::vector<uint32_t> unsorted_slots; // Inserted or moved to another bucket since the last sort
+	std::vector<uint32_t> stale_buckets; // Buckets that entries moved out of or were removed from since the last sort
+
+	struct Move {
+		uint32_t slot;
+		uint32_t old_bucket;
+	};
+
+	struct Counts {
+		size_t seen; // Already indexed
+		size_t missing; // Not indexed yet
+		size_t moved; // To another bucket, listed in chunk_moves while few enough to be merged
+	};
+
+	// Scratch memory of rebuild(), update() and merge_moved(), kept between calls. One element per chunk of parallel_for.
+	std::vector<size_t> chunk_removed;
+	std::vector<Counts> chunk_counts;
+	std::vector<std::vector<Move>> chunk_moves;
+	std::vector<uint64_t> merge_keys;
+	std::vector<uint32_t> merge_slots;
+
+	size_t num_live;
+	uint32_t stamp;
+
+	static uint32_t bucketCountFor(size_t count);
+	void add_entry(EntityId entity, yks::vec2 position);
+	void set_position(uint32_t slot, yks::vec2 position);
+	uint32_t bucket_of(int32_t cell_x, int32_t cell_y) const;
+	/** Sorts all live entries into buckets again, dropping removed ones. */
+	void sort_entries();
+	void maybe_sort();
+	/** Puts the live entries that aren't sorted into their buckets, in one
+	 * pass over the sorted ones. Removed entries are dropped from the order. */
+	void merge_moved();
+
+	template <typename Fn>
+	void for_each_in_cells(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const Fn& fn) const;
+};
@@ -53,6 +53,14 @@ yks::Handle TextureManager::loadTexture(const std::string& name, const std::stri
 	return h;
 }
 
+yks::MemoryUsage TextureManager::getMemoryUsage() const {
+	yks::MemoryUsage usage = texture_pool.getMemoryUsage();
+	for (const Texture& tex : texture_pool.pool) {
+		usage.bytes += tex.size[0] * tex.size[1] * 4;
+	}
+	return usage;
+}
+
 void TextureManager::deleteTexture(yks::Handle h) {
 	Texture* tex = texture_pool[h];
 	freeGLTexture(tex->api_handle);
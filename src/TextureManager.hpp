@@ -1,5 +1,6 @@
 #pragma once
 #include "Handle.hpp"
+#include "memory/MemoryStats.hpp"
 #include "memory/ObjectPool.hpp"
 #include "math/vec.hpp"
 #include <string>
@@ -20,6 +21,9 @@ struct TextureManager {
 	yks::Handle loadTexture(const std::string& name, const std::string& filename, LoadOptions options = LoadOptions());
 	void deleteTexture(yks::Handle h);
 
+	/** Bytes include the estimated size of texture data on the GPU. */
+	yks::MemoryUsage getMemoryUsage() const;
+
 	const Texture* operator[](yks::Handle h) const {
 		return texture_pool[h];
 	}
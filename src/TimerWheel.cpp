@@ -0,0 +1,127 @@
+#include "TimerWheel.hpp"
+
+TimerWheel::TimerWheel()
+	: current_tick(0)
+{}
+
+TimerId TimerWheel::schedule(yks::Handle owner, TimerEventId event, uint64_t delay) {
+	if (delay == 0) {
+		delay = 1;
+	}
+
+	TimerId id = timers.emplace(owner, event, current_tick + delay);
+	link(id, *timers[id]);
+	link_owner(id, *timers[id]);
+	return id;
+}
+
+void TimerWheel::cancel(TimerId id) {
+	Timer* t = timers[id];
+	if (t == nullptr)
+		return;
+
+	unlink(*t);
+	unlink_owner(*t);
+	timers.remove(id);
+}
+
+void TimerWheel::cancelOwner(yks::Handle owner) {
+	if (owner.index >= owner_timers.size())
+		return;
+
+	// The list also holds timers of other generations of the same roster index
+	TimerId h = owner_timers[owner.index];
+	while (!h.isNull()) {
+		const Timer* t = timers[h];
+		const TimerId next = t->owner_next;
+		if (t->owner == owner) {
+			cancel(h);
+		}
+		h = next;
+	}
+}
+
+bool TimerWheel::isPending(TimerId id) const {
+	return timers.isValid(id);
+}
+
+void TimerWheel::link(TimerId id, Timer& t) {
+	// Find the finest wheel where the expiry is less than a full turn away
+	unsigned int level = 0;
+	uint64_t slot_pos = t.expiry;
+	while (level < num_levels) {
+		const unsigned int shift = slot_bits * level;
+		slot_pos = t.expiry >> shift;
+		if (slot_pos - (current_tick >> shift) < num_slots)
+			break;
+		++level;
+	}
+
+	if (level == num_levels) {
+		// Too far in the future, park it in the last slot of the top wheel.
+		// It'll get re-linked when that slot cascades.
+		level = num_levels - 1;
+		slot_pos = (current_tick >> (slot_bits * level)) + num_slots - 1;
+	}
+
+	t.slot = level * num_slots + (slot_pos & (num_slots - 1));
+	t.prev = TimerId();
+	t.next = slots[t.slot];
+	if (!t.next.isNull()) {
+		timers[t.next]->prev = id;
+	}
+	slots[t.slot] = id;
+}
+
+void TimerWheel::unlink(Timer& t) {
+	if (t.prev.isNull()) {
+		slots[t.slot] = t.next;
+	} else {
+		timers[t.prev]->next = t.next;
+	}
+	if (!t.next.isNull()) {
+		timers[t.next]->prev = t.prev;
+	}
+}
+
+void TimerWheel::link_owner(TimerId id, Timer& t) {
+	if (t.owner.isNull())
+		return;
+
+	if (owner_timers.size() <= t.owner.index) {
+		owner_timers.resize(t.owner.index + 1);
+	}
+	t.owner_prev = TimerId();
+	t.owner_next = owner_timers[t.owner.index];
+	if (!t.owner_next.isNull()) {
+		timers[t.owner_next]->owner_prev = id;
+	}
+	owner_timers[t.owner.index] = id;
+}
+
+void TimerWheel::unlink_owner(Timer& t) {
+	if (t.owner.isNull())
+		return;
+
+	if (t.owner_prev.isNull()) {
+		owner_timers[t.owner.index] = t.owner_next;
+	} else {
+		timers[t.owner_prev]->owner_next = t.owner_next;
+	}
+	if (!t.owner_next.isNull()) {
+		timers[t.owner_next]->owner_prev = t.owner_prev;
+	}
+}
+
+void TimerWheel::cascade(unsigned int level) {
+	const uint32_t slot = level * num_slots + ((current_tick >> (slot_bits * level)) & (num_slots - 1));
+
+	TimerId h = slots[slot];
+	slots[slot] = TimerId();
+	while (!h.isNull()) {
+		Timer& t = *timers[h];
+		const TimerId next = t.next;
+		link(h, t);
+		h = next;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Handle.hpp"
+#include "memory/ObjectPool.hpp"
+#include <cstdint>
+#include <vector>
+
+typedef yks::Handle TimerId;
+typedef uint32_t TimerEventId;
+
+/** Hierarchical timing wheel. Timers are scheduled in ticks and are bucketed
+ * by their expiry time in progressively coarser wheels. Scheduling and
+ * cancelling are O(1), and advancing only touches timers that expire or get
+ * cascaded down into a finer wheel. */
+struct TimerWheel {
+	static const unsigned int slot_bits = 6;
+	static const unsigned int num_slots = 1 << slot_bits;
+	static const unsigned int num_levels = 4;
+
+	struct Timer {
+		yks::Handle owner;
+		TimerEventId event;
+		uint64_t expiry;
+
+		// Intrusive list links inside the owning slot.
+		TimerId prev, next;
+		uint32_t slot;
+		// Intrusive list links among the timers of owners with the same roster index.
+		TimerId owner_prev, owner_next;
+
+		Timer(yks::Handle owner, TimerEventId event, uint64_t expiry)
+			: owner(owner), event(event), expiry(expiry), slot(0)
+		{}
+	};
+
+	uint64_t current_tick;
+	yks::ObjectPool<Timer> timers;
+	// Extra slot past the wheels holds the timers being fired by advance
+	static const uint32_t firing_slot = num_levels * num_slots;
+	TimerId slots[num_levels * num_slots + 1];
+	// Head of the timer list of each owner roster index.
+	std::vector<TimerId> owner_timers;
+
+	TimerWheel();
+
+	/** Schedules a timer to fire `delay` ticks from now. A delay of 0 fires on the next tick. */
+	TimerId schedule(yks::Handle owner, TimerEventId event, uint64_t delay);
+	/** Cancels a pending timer. Does nothing if it already fired or was cancelled. */
+	void cancel(TimerId id);
+	/** Cancels every pending timer of owner. */
+	void cancelOwner(yks::Handle owner);
+	bool isPending(TimerId id) const;
+
+	/** Advances the wheel by one tick, calling fn(owner, event) for each expired timer. */
+	template <typename Fn>
+	void advance(const Fn& fn) {
+		++current_tick;
+
+		// Cascade coarser wheels whose slot just came up, highest first
+		for (unsigned int level = num_levels - 1; level > 0; --level) {
+			const uint64_t mask = (uint64_t(1) << (slot_bits * level)) - 1;
+			if ((current_tick & mask) == 0) {
+				cascade(level);
+			}
+		}
+
+		// Move the slot to the firing list before calling back, so fn can
+		// freely schedule new timers and cancel ones that haven't fired yet
+		const uint32_t slot = current_tick & (num_slots - 1);
+		slots[firing_slot] = slots[slot];
+		slots[slot] = TimerId();
+		for (TimerId h = slots[firing_slot]; !h.isNull(); h = timers[h]->next) {
+			timers[h]->slot = firing_slot;
+		}
+
+		while (!slots[firing_slot].isNull()) {
+			const TimerId h = slots[firing_slot];
+			Timer* t = timers[h];
+			assert(t != nullptr && t->expiry == current_tick);
+			const yks::Handle owner = t->owner;
+			const TimerEventId event = t->event;
+			unlink(*t);
+			unlink_owner(*t);
+			timers.remove(h);
+
+			fn(owner, event);
+		}
+	}
+
+private:
+	void link(TimerId id, Timer& t);
+	void unlink(Timer& t);
+	void link_owner(TimerId id, Timer& t);
+	void unlink_owner(Timer& t);
+	void cascade(unsigned int level);
+};
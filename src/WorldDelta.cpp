@@ -0,0 +1,359 @@
+#include "WorldDelta.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+
+void WorldSnapshot::clear() {
+	entities.clear();
+	disabled.clear();
+	components.clear();
+	data.clear();
+}
+
+void WorldDeltaEncoder::add_reader(ComponentTypeId type, size_t size, const std::function<const void*(ComponentHandle)>& get) {
+	if (readers.size() <= type) {
+		readers.resize(type + 1);
+	}
+	readers[type].size = size;
+	readers[type].get = get;
+}
+
+void WorldDeltaEncoder::takeSnapshot(EntityWorld& world, WorldSnapshot& out) const {
+	out.clear();
+
+	for (auto e : world.entities) {
+		out.entities.push_back(e.first);
+	}
+	std::sort(out.entities.begin(), out.entities.end());
+
+	// Parked entities keep their components, so they'd look alive without this
+	for (EntityId id : out.entities) {
+		if (!world.isEntityEnabled(id)) {
+			out.disabled.push_back(id);
+		}
+	}
+
+	for (EntityId id : out.entities) {
+		for (const auto& c : world.entities[id]->components.data) {
+			WorldSnapshot::ComponentRecord rec;
+			rec.entity = id;
+			rec.type = std::get<0>(c);
+			rec.offset = out.data.size();
+			rec.size = 0;
+
+			if (rec.type < readers.size() && readers[rec.type].get) {
+				const Reader& reader = readers[rec.type];
+				const uint8_t* bytes = static_cast<const uint8_t*>(reader.get(std::get<1>(c)));
+				if (bytes != nullptr) {
+					rec.size = reader.size;
+					out.data.insert(out.data.end(), bytes, bytes + reader.size);
+				}
+			}
+			out.components.push_back(rec);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////
+
+static void writeVarint(std::vector<uint8_t>& out, uint64_t x) {
+	while (x >= 0x80) {
+		out.push_back(static_cast<uint8_t>(x | 0x80));
+		x >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(x));
+}
+
+static void writeEntity(std::vector<uint8_t>& out, EntityId e) {
+	writeVarint(out, e.index);
+	writeVarint(out, e.generation);
+}
+
+struct DeltaReader {
+	const uint8_t* p;
+	const uint8_t* end;
+	bool ok;
+
+	uint64_t varint() {
+		uint64_t x = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (p == end) {
+				ok = false;
+				return 0;
+			}
+			const uint8_t b = *p++;
+			x |= uint64_t(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return x;
+		}
+		ok = false;
+		return 0;
+	}
+
+	EntityId entity() {
+		const size_t index = static_cast<size_t>(varint());
+		const uint32_t generation = static_cast<uint32_t>(varint());
+		return EntityId(index, generation);
+	}
+
+	/** Returns count, or 0 and fails if fewer than count * min_bytes bytes remain. */
+	size_t count(size_t min_bytes) {
+		const uint64_t n = varint();
+		if (n > uint64_t(end - p) / min_bytes) {
+			ok = false;
+			return 0;
+		}
+		return static_cast<size_t>(n);
+	}
+};
+
+static bool entityLess(EntityId a, EntityId b) {
+	return std::tie(a.index, a.generation) < std::tie(b.index, b.generation);
+}
+
+static bool recordLess(const WorldSnapshot::ComponentRecord& a, const WorldSnapshot::ComponentRecord& b) {
+	return std::tie(a.entity.index, a.entity.generation, a.type) < std::tie(b.entity.index, b.entity.generation, b.type);
+}
+
+static bool containsEntity(const std::vector<EntityId>& sorted, EntityId e) {
+	return std::binary_search(sorted.begin(), sorted.end(), e, entityLess);
+}
+
+/** XORs old_bytes with new_bytes and writes the result as alternating runs:
+ * a count of zero bytes, then a count of literal bytes followed by them. */
+static void writeXorRle(std::vector<uint8_t>& out, const uint8_t* old_bytes, const uint8_t* new_bytes, size_t size) {
+	size_t i = 0;
+	while (i < size) {
+		const size_t zeros_begin = i;
+		while (i < size && old_bytes[i] == new_bytes[i]) {
+			++i;
+		}
+		const size_t literals_begin = i;
+		while (i < size && old_bytes[i] != new_bytes[i]) {
+			++i;
+		}
+		writeVarint(out, literals_begin - zeros_begin);
+		writeVarint(out, i - literals_begin);
+		for (size_t j = literals_begin; j < i; ++j) {
+			out.push_back(old_bytes[j] ^ new_bytes[j]);
+		}
+	}
+}
+
+static bool applyXorRle(DeltaReader& in, uint8_t* bytes, size_t size) {
+	size_t i = 0;
+	while (i < size) {
+		const size_t zeros = static_cast<size_t>(in.varint());
+		const size_t literals = static_cast<size_t>(in.varint());
+		if (!in.ok || zeros > size - i || literals > size - i - zeros || literals > size_t(in.end - in.p))
+			return false;
+
+		i += zeros;
+		for (size_t j = 0; j < literals; ++j) {
+			bytes[i++] ^= *in.p++;
+		}
+	}
+	return true;
+}
+
+void WorldDeltaEncoder::encodeDelta(const WorldSnapshot& from, const WorldSnapshot& to, std::vector<uint8_t>& out) {
+	// Entities
+	std::vector<EntityId> destroyed;
+	std::vector<EntityId> created;
+	std::set_difference(from.entities.begin(), from.entities.end(), to.entities.begin(), to.entities.end(), std::back_inserter(destroyed), entityLess);
+	std::set_difference(to.entities.begin(), to.entities.end(), from.entities.begin(), from.entities.end(), std::back_inserter(created), entityLess);
+
+	writeVarint(out, destroyed.size());
+	for (EntityId e : destroyed) {
+		writeEntity(out, e);
+	}
+	writeVarint(out, created.size());
+	for (EntityId e : created) {
+		writeEntity(out, e);
+	}
+
+	// Disabled state. Destroyed entities drop theirs implicitly.
+	std::vector<EntityId> disabled;
+	std::vector<EntityId> enabled;
+	std::set_difference(to.disabled.begin(), to.disabled.end(), from.disabled.begin(), from.disabled.end(), std::back_inserter(disabled), entityLess);
+	std::set_difference(from.disabled.begin(), from.disabled.end(), to.disabled.begin(), to.disabled.end(), std::back_inserter(enabled), entityLess);
+	enabled.erase(std::remove_if(enabled.begin(), enabled.end(), [&](EntityId e) { return containsEntity(destroyed, e); }), enabled.end());
+
+	writeVarint(out, disabled.size());
+	for (EntityId e : disabled) {
+		writeEntity(out, e);
+	}
+	writeVarint(out, enabled.size());
+	for (EntityId e : enabled) {
+		writeEntity(out, e);
+	}
+
+	// Components. Those of destroyed entities are dropped implicitly.
+	std::vector<const WorldSnapshot::ComponentRecord*> removed;
+	std::vector<const WorldSnapshot::ComponentRecord*> added;
+	std::vector<std::pair<const WorldSnapshot::ComponentRecord*, const WorldSnapshot::ComponentRecord*>> changed;
+
+	auto a = from.components.begin();
+	auto b = to.components.begin();
+	while (a != from.components.end() || b != to.components.end()) {
+		if (b == to.components.end() || (a != from.components.end() && recordLess(*a, *b))) {
+			if (!containsEntity(destroyed, a->entity)) {
+				removed.push_back(&*a);
+			}
+			++a;
+		} else if (a == from.components.end() || recordLess(*b, *a)) {
+			added.push_back(&*b);
+			++b;
+		} else {
+			if (a->size != b->size) {
+				removed.push_back(&*a);
+				added.push_back(&*b);
+			} else if (std::memcmp(from.data.data() + a->offset, to.data.data() + b->offset, a->size) != 0) {
+				changed.push_back(std::make_pair(&*a, &*b));
+			}
+			++a;
+			++b;
+		}
+	}
+
+	writeVarint(out, removed.size());
+	for (const auto* r : removed) {
+		writeEntity(out, r->entity);
+		writeVarint(out, r->type);
+	}
+	writeVarint(out, added.size());
+	for (const auto* r : added) {
+		writeEntity(out, r->entity);
+		writeVarint(out, r->type);
+		writeVarint(out, r->size);
+		out.insert(out.end(), to.data.begin() + r->offset, to.data.begin() + r->offset + r->size);
+	}
+	writeVarint(out, changed.size());
+	for (const auto& c : changed) {
+		writeEntity(out, c.second->entity);
+		writeVarint(out, c.second->type);
+		writeXorRle(out, from.data.data() + c.first->offset, to.data.data() + c.second->offset, c.second->size);
+	}
+}
+
+bool WorldDeltaEncoder::applyDelta(const WorldSnapshot& from, const uint8_t* delta, size_t delta_size, WorldSnapshot& to) {
+	DeltaReader in = { delta, delta + delta_size, true };
+	to.clear();
+
+	// Entities
+	std::vector<EntityId> destroyed(in.count(2));
+	for (EntityId& e : destroyed) {
+		e = in.entity();
+	}
+	std::vector<EntityId> created(in.count(2));
+	for (EntityId& e : created) {
+		e = in.entity();
+	}
+	if (!in.ok)
+		return false;
+
+	std::sort(destroyed.begin(), destroyed.end(), entityLess);
+	for (EntityId e : from.entities) {
+		if (!containsEntity(destroyed, e)) {
+			to.entities.push_back(e);
+		}
+	}
+	to.entities.insert(to.entities.end(), created.begin(), created.end());
+	std::sort(to.entities.begin(), to.entities.end(), entityLess);
+
+	// Disabled state
+	std::vector<EntityId> disabled(in.count(2));
+	for (EntityId& e : disabled) {
+		e = in.entity();
+	}
+	std::vector<EntityId> enabled(in.count(2));
+	for (EntityId& e : enabled) {
+		e = in.entity();
+	}
+	if (!in.ok)
+		return false;
+
+	std::sort(enabled.begin(), enabled.end(), entityLess);
+	for (EntityId e : from.disabled) {
+		if (!containsEntity(destroyed, e) && !containsEntity(enabled, e)) {
+			to.disabled.push_back(e);
+		}
+	}
+	for (EntityId e : disabled) {
+		if (!containsEntity(to.entities, e))
+			return false;
+		to.disabled.push_back(e);
+	}
+	std::sort(to.disabled.begin(), to.disabled.end(), entityLess);
+	if (std::adjacent_find(to.disabled.begin(), to.disabled.end()) != to.disabled.end())
+		return false;
+
+	// Components, gathered with their own bytes and laid out into to.data at the end
+	typedef std::tuple<WorldSnapshot::ComponentRecord, std::vector<uint8_t>> Component;
+	std::vector<Component> components;
+
+	std::vector<WorldSnapshot::ComponentRecord> removed(in.count(3));
+	for (auto& r : removed) {
+		r.entity = in.entity();
+		r.type = static_cast<ComponentTypeId>(in.varint());
+	}
+	if (!in.ok)
+		return false;
+	std::sort(removed.begin(), removed.end(), recordLess);
+
+	const size_t num_added = in.count(4);
+	for (size_t i = 0; i < num_added && in.ok; ++i) {
+		WorldSnapshot::ComponentRecord r;
+		r.entity = in.entity();
+		r.type = static_cast<ComponentTypeId>(in.varint());
+		r.size = static_cast<size_t>(in.varint());
+		if (r.size > size_t(in.end - in.p))
+			return false;
+
+		components.push_back(Component(r, std::vector<uint8_t>(in.p, in.p + r.size)));
+		in.p += r.size;
+	}
+	if (!in.ok)
+		return false;
+
+	const size_t first_kept = components.size();
+	for (const auto& r : from.components) {
+		if (containsEntity(destroyed, r.entity) || std::binary_search(removed.begin(), removed.end(), r, recordLess))
+			continue;
+		components.push_back(Component(r, std::vector<uint8_t>(from.data.begin() + r.offset, from.data.begin() + r.offset + r.size)));
+	}
+
+	// Kept components are still sorted, so changes can binary search them
+	const auto kept_less = [](const Component& c, const WorldSnapshot::ComponentRecord& r) {
+		return recordLess(std::get<0>(c), r);
+	};
+	const size_t num_changed = in.count(3);
+	for (size_t i = 0; i < num_changed && in.ok; ++i) {
+		WorldSnapshot::ComponentRecord key;
+		key.entity = in.entity();
+		key.type = static_cast<ComponentTypeId>(in.varint());
+
+		auto c = std::lower_bound(components.begin() + first_kept, components.end(), key, kept_less);
+		if (c == components.end() || recordLess(key, std::get<0>(*c)))
+			return false;
+
+		std::vector<uint8_t>& bytes = std::get<1>(*c);
+		if (!applyXorRle(in, bytes.data(), bytes.size()))
+			return false;
+	}
+	if (!in.ok || in.p != in.end)
+		return false;
+
+	std::sort(components.begin(), components.end(), [](const Component& x, const Component& y) {
+		return recordLess(std::get<0>(x), std::get<0>(y));
+	});
+	for (auto& c : components) {
+		WorldSnapshot::ComponentRecord r = std::get<0>(c);
+		r.offset = to.data.size();
+		r.size = std::get<1>(c).size();
+		to.data.insert(to.data.end(), std::get<1>(c).begin(), std::get<1>(c).end());
+		to.components.push_back(r);
+	}
+	return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "EntitySystem.hpp"
+#include "memory/ObjectPool.hpp"
+#include "memory/SharedObjectPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+/** Copy of the structure of an EntityWorld, plus the bytes of every
+ * component whose pool was registered with the WorldDeltaEncoder. */
+struct WorldSnapshot {
+	struct ComponentRecord {
+		EntityId entity;
+		ComponentTypeId type;
+		size_t offset; // Into data
+		size_t size; // Zero for components of unregistered types
+	};
+
+	std::vector<EntityId> entities; // Sorted by index
+	std::vector<EntityId> disabled; // Subset of entities, sorted by index
+	std::vector<ComponentRecord> components; // Sorted by entity index, then type
+	std::vector<uint8_t> data;
+
+	void clear();
+};
+
+/** Produces compact deltas between two snapshots of a world, for replays
+ * and for streaming state to tools. A delta lists destroyed and created
+ * entities, entities that were disabled or enabled, removed and added
+ * components, and for components present in both snapshots, the XOR of the
+ * old and new bytes, run-length encoded so unchanged bytes cost next to
+ * nothing. Entity names aren't included. */
+struct WorldDeltaEncoder {
+	/** Registers pool so that the bytes of its components are captured. Pool
+	 * is an ObjectPool of the component type, with any Storage. */
+	template <typename Pool>
+	void addPool(const Pool& pool) {
+		typedef typename Pool::value_type C;
+		static_assert(std::is_trivially_copyable<C>::value, "Component data is copied bytewise.");
+		add_reader(C::component_id, sizeof(C), [&pool](ComponentHandle h) -> const void* { return pool[h]; });
+	}
+
+	template <typename C>
+	void addPool(const yks::SharedObjectPool<C>& pool) {
+		static_assert(std::is_trivially_copyable<C>::value, "Component data is copied bytewise.");
+		add_reader(C::component_id, sizeof(C), [&pool](ComponentHandle h) -> const void* { return pool[h]; });
+	}
+
+	void takeSnapshot(EntityWorld& world, WorldSnapshot& out) const;
+
+	/** Appends the delta turning from into to. */
+	static void encodeDelta(const WorldSnapshot& from, const WorldSnapshot& to, std::vector<uint8_t>& out);
+	/** Rebuilds to from from and a delta made by encodeDelta. Returns false if the delta is malformed. */
+	static bool applyDelta(const WorldSnapshot& from, const uint8_t* delta, size_t delta_size, WorldSnapshot& to);
+
+private:
+	struct Reader {
+		size_t size;
+		std::function<const void*(ComponentHandle)> get;
+	};
+
+	std::vector<Reader> readers; // Indexed by ComponentTypeId
+
+	void add_reader(ComponentTypeId type, size_t size, const std::function<const void*(ComponentHandle)>& get);
+};
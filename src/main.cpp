@@ -1,9 +1,14 @@
 #include "EntityQuery.hpp"
 #include "EntitySystem.hpp"
+#include "GameWorld.hpp"
 #include "math/vec.hpp"
+#include <fstream>
 #include <iostream>
 #include "TextureManager.hpp"
+#include "memory/FrameArena.hpp"
+#include "memory/MemoryStats.hpp"
 #include "memory/ObjectPool.hpp"
+#include "memory/SharedObjectPool.hpp"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_main.h>
@@ -15,60 +20,12 @@
 
 using namespace yks;
 
-EntityWorld world;
-
-struct Position  {
-	static const ComponentTypeId component_id = 0;
-
-	vec2 position;
-
-	Position(vec2 position)
-		: position(position)
-	{}
-};
-ObjectPool<Position> positionPool;
-
-struct Velocity {
-	static const ComponentTypeId component_id = 1;
-
-	vec2 velocity;
-
-	Velocity(vec2 velocity)
-		: velocity(velocity)
-	{}
-};
-ObjectPool<Velocity> velocityPool;
-
-struct SpriteRenderer {
-	static const ComponentTypeId component_id = 2;
-
-	int layer;
-	IntRect img_rect;
-
-	SpriteRenderer(int layer, IntRect img_rect)
-		: layer(layer), img_rect(img_rect)
-	{}
-};
-ObjectPool<SpriteRenderer> spriteRendererPool;
-
-struct Gravity {
-	static const ComponentTypeId component_id = 3;
-
-	vec2 acceleration;
-
-	Gravity(vec2 acceleration)
-		: acceleration(acceleration)
-	{}
-};
-ObjectPool<Gravity> gravityPool;
-
 TextureManager texture_manager;
+MemoryStatsRegistry memory_stats;
 
 int main(int argc, char *argv[]) {
-	world.addComponentType(Position::component_id, "Position");
-	world.addComponentType(Velocity::component_id, "Velocity");
-	world.addComponentType(SpriteRenderer::component_id, "SpriteRenderer");
-	world.addComponentType(Gravity::component_id, "Gravity");
+	GameWorld game;
+	EntityWorld& world = game.world;
 
 	Handle e0 = world.createEntity("pos");
 	Handle e1 = world.createEntity("pos_circle");
@@ -76,22 +33,24 @@ int main(int argc, char *argv[]) {
 	Handle e3 = world.createEntity("pos_vel_circle1");
 	Handle e4 = world.createEntity("pos_vel_circle2");
 
-	world.addComponentToEntity(positionPool, e0, vec2{{0, 0}});
+	world.addComponentToEntity(game.positionPool, e0, vec2{{0, 0}});
 
-	world.addComponentToEntity(positionPool, e1, vec2{{0, 0}});
-	world.addComponentToEntity(spriteRendererPool, e1, 0, IntRect{32, 0, 16, 16});
+	world.addComponentToEntity(game.positionPool, e1, vec2{{0, 0}});
+	world.addComponentToEntity(game.spriteRendererPool, e1, 0, IntRect{32, 0, 16, 16});
 
-	world.addComponentToEntity(positionPool, e2, vec2{{0, 0}});
-	world.addComponentToEntity(velocityPool, e2, vec2{{2, 1}});
+	world.addComponentToEntity(game.positionPool, e2, vec2{{0, 0}});
+	world.addComponentToEntity(game.velocityPool, e2, vec2{{2, 1}});
 
-	world.addComponentToEntity(positionPool, e3, vec2{{0, 0}});
-	world.addComponentToEntity(velocityPool, e3, vec2{{1, 0}});
-	world.addComponentToEntity(gravityPool, e3, vec2{{0, 0.03}});
-	world.addComponentToEntity(spriteRendererPool, e3, 0, IntRect{32, 0, 16, 16});
+	world.addComponentToEntity(game.positionPool, e3, vec2{{0, 0}});
+	world.addComponentToEntity(game.velocityPool, e3, vec2{{1, 0}});
+	world.addComponentToEntity(game.gravityPool, e3, vec2{{0, 0.03}});
+	world.addComponentToEntity(game.spriteRendererPool, e3, 0, IntRect{32, 0, 16, 16});
+	world.addComponentToEntity(game.colliderPool, e3, vec2{{0, 0}}, vec2{{16, 16}});
 
-	world.addComponentToEntity(positionPool, e4, vec2{{0, 0}});
-	world.addComponentToEntity(velocityPool, e4, vec2{{2, 2}});
-	world.addComponentToEntity(spriteRendererPool, e4, 0, IntRect{32, 0, 16, 16});
+	world.addComponentToEntity(game.positionPool, e4, vec2{{0, 0}});
+	world.addComponentToEntity(game.velocityPool, e4, vec2{{2, 2}});
+	world.addComponentToEntity(game.spriteRendererPool, e4, 0, IntRect{32, 0, 16, 16});
+	world.addComponentToEntity(game.colliderPool, e4, vec2{{0, 0}}, vec2{{16, 16}});
 
 	Window window;
 	if (!window.open(640, 480)) {
@@ -125,6 +84,15 @@ int main(int argc, char *argv[]) {
 
 	Sprite spr;
 
+	memory_stats.track("world", world);
+	memory_stats.track("positionPool", game.positionPool);
+	memory_stats.track("velocityPool", game.velocityPool);
+	memory_stats.track("spriteRendererPool", game.spriteRendererPool);
+	memory_stats.track("gravityPool", game.gravityPool);
+	memory_stats.track("colliderPool", game.colliderPool);
+	memory_stats.track("texture_manager", texture_manager);
+	memory_stats.track("frame_arena", game.frame_arena);
+
 	for (;;) {
 		main_buffer.clear();
 
@@ -132,15 +100,9 @@ int main(int argc, char *argv[]) {
 
 		glBindTexture(GL_TEXTURE_2D, texture_manager[tex]->api_handle);
 
-		query_for_each(world, std::tie(velocityPool, gravityPool), [&](Velocity& vel, const Gravity& gravity) {
-			vel.velocity += gravity.acceleration;
-		});
-
-		query_for_each(world, std::tie(positionPool, velocityPool), [&](Position& pos, const Velocity& vel) {
-			pos.position += vel.velocity;
-		});
+		game.update();
 
-		query_for_each(world, std::tie(positionPool, spriteRendererPool), [&](const Position& pos, const SpriteRenderer& renderer) {
+		query_for_each_shared(world, game.spriteRendererPool, std::tie(game.positionPool), [&](const SpriteRenderer& renderer, const Position& pos) {
 			spr.pos = pos.position.typecast<int>();
 			spr.img = renderer.img_rect;
 			main_buffer.append(spr);
@@ -149,6 +111,7 @@ int main(int argc, char *argv[]) {
 		main_buffer.draw(spr_indices);
 
 		window.flip();
+		memory_stats.sample();
 
 		SDL_Event ev;
 		SDL_WaitEvent(&ev);
@@ -157,6 +120,9 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	std::ofstream stats_file("memory_stats.json");
+	memory_stats.dumpJson(stats_file);
+
 	window.close();
 	SDL_Quit();
 
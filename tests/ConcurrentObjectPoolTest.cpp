@@ -0,0 +1,53 @@
+// Stress test for ConcurrentObjectPool. Build and run from the repository root:
+//   g++ -std=c++11 -pthread -Isrc -Ilibyuriks tests/ConcurrentObjectPoolTest.cpp -o ConcurrentObjectPoolTest && ./ConcurrentObjectPoolTest
+// Adding -fsanitize=thread also checks for data races.
+#include "memory/ConcurrentObjectPool.hpp"
+#include "check.hpp"
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace yks;
+
+static void testConcurrentInsertRemove() {
+	static const int num_threads = 16;
+	static const int iterations = 100000;
+	static const int live_per_thread = 64;
+
+	ConcurrentObjectPool<std::pair<int, int>> objp(num_threads * live_per_thread);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([&objp, t]() {
+			Handle live[live_per_thread];
+			for (int i = 0; i < iterations; ++i) {
+				Handle& h = live[i % live_per_thread];
+				if (!h.isNull()) {
+					const std::pair<int, int>* p = objp[h];
+					CHECK(p && p->first == t && p->second == i - live_per_thread);
+					objp.remove(h);
+					CHECK(!objp[h]);
+				}
+				h = objp.emplace(t, i);
+				CHECK(!h.isNull());
+			}
+			for (Handle h : live) {
+				objp.remove(h);
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	int remaining = 0;
+	objp.for_each([&](Handle, std::pair<int, int>&) { ++remaining; });
+	CHECK(remaining == 0);
+}
+
+int main() {
+	testConcurrentInsertRemove();
+	std::puts("ConcurrentObjectPoolTest passed");
+	return 0;
+}
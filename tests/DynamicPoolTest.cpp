@@ -0,0 +1,129 @@
+// Tests for the type-erased DynamicPool. Build and run from the repository root:
+//   g++ -std=c++11 -Isrc -Ilibyuriks tests/DynamicPoolTest.cpp libyuriks/memory/DynamicPool.cpp libyuriks/memory/DynamicPoolAllocator.cpp libyuriks/memory/VirtualMemory.cpp -o DynamicPoolTest && ./DynamicPoolTest
+#include "memory/TypedDynamicPool.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace yks;
+
+static void testNonTrivialType() {
+	TypedDynamicPool<std::string> pool;
+	std::vector<Handle> handles;
+	for (int i = 0; i < 100; ++i) {
+		const std::string s(40, char('a' + i % 26)); // Too long for the small string buffer
+		handles.push_back(i % 2 ? pool.insert(s) : pool.emplace(s));
+	}
+	for (int i = 0; i < 100; i += 3) {
+		pool.remove(handles[i]);
+	}
+
+	const TypedDynamicPool<std::string> copy = pool;
+	for (int i = 0; i < 100; ++i) {
+		const std::string expected(40, char('a' + i % 26));
+		if (i % 3 == 0) {
+			CHECK(pool[handles[i]] == nullptr);
+		} else {
+			CHECK(*pool[handles[i]] == expected);
+			CHECK(*copy[handles[i]] == expected);
+		}
+	}
+}
+
+static void testMoveOnlyType() {
+	TypedDynamicPool<std::unique_ptr<int>> pool;
+	std::vector<Handle> handles;
+	for (int i = 0; i < 100; ++i) {
+		std::unique_ptr<int> p(new int(i));
+		handles.push_back(pool.insert(std::move(p)));
+		CHECK(p == nullptr);
+	}
+	for (int i = 0; i < 100; i += 2) {
+		pool.remove(handles[i]);
+	}
+	for (int i = 1; i < 100; i += 2) {
+		CHECK(**pool[handles[i]] == i);
+	}
+
+	// Copying would duplicate the pointers, so it has to fail instead
+	bool threw = false;
+	try {
+		DynamicPool copy = pool;
+	} catch (const std::logic_error&) {
+		threw = true;
+	}
+	CHECK(threw);
+
+	std::unique_ptr<int> p(new int(-1));
+	threw = false;
+	try {
+		static_cast<DynamicPool&>(pool).insert(&p);
+	} catch (const std::logic_error&) {
+		threw = true;
+	}
+	CHECK(threw);
+	CHECK(*p == -1);
+	CHECK(pool.pool.size() == 50);
+	CHECK(pool.isValid(pool.makeHandle(pool.pool.size() - 1)));
+}
+
+struct Aligned {
+	alignas(32) float values[8];
+};
+
+static void testAlignment() {
+	TypedDynamicPool<Aligned> pool;
+	for (int i = 0; i < 100; ++i) {
+		const Handle h = pool.emplace();
+		CHECK(reinterpret_cast<uintptr_t>(pool[h]) % 32 == 0);
+	}
+}
+
+static void testReservedRangeExhausted() {
+	// 24 bytes don't divide the commit granularity, so a page can end inside an object
+	struct Obj {
+		uint64_t a, b, c;
+	};
+	TypedDynamicPool<Obj> pool;
+	pool.pool.reserveVirtual(1000);
+
+	size_t inserted = 0;
+	bool threw = false;
+	try {
+		for (; inserted < 1000000; ++inserted) {
+			const Obj o = { inserted, inserted, inserted };
+			pool.insert(o);
+		}
+	} catch (const std::bad_alloc&) {
+		threw = true;
+	}
+	CHECK(threw);
+	CHECK(inserted >= 1000);
+	CHECK(pool.pool.size() == inserted);
+	CHECK(pool.pool.size() <= pool.pool.capacity());
+	for (size_t i = 0; i < inserted; ++i) {
+		CHECK(pool[pool.makeHandle(i)]->c == i);
+	}
+
+	threw = false;
+	try {
+		pool.pool.reserve(inserted * 2);
+	} catch (const std::bad_alloc&) {
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+int main() {
+	testNonTrivialType();
+	testMoveOnlyType();
+	testAlignment();
+	testReservedRangeExhausted();
+	std::puts("DynamicPoolTest passed");
+	return 0;
+}
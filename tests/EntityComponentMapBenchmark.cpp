@@ -0,0 +1,79 @@
+// Times component map lookups and removals against a plain SortedVector.
+// Build and run from the repository root:
+//   g++ -std=c++11 -O2 -Isrc -Ilibyuriks tests/EntityComponentMapBenchmark.cpp -o EntityComponentMapBenchmark && ./EntityComponentMapBenchmark
+#include "EntitySystem.hpp"
+#include "check.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+typedef EntityWorld::EntityComponentMap Map;
+typedef Map::Storage::value_type Entry;
+
+// Time per call of fn(i) for i in [0, count), in nanoseconds
+static double timePerCall(size_t count, const std::function<void(size_t)>& fn) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < count; ++i) {
+		fn(i);
+	}
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	return double(ns) / count;
+}
+
+static void benchmark(size_t n) {
+	// Every other roster index has the component, so half of the lookups miss
+	std::vector<Entry> entries;
+	entries.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		entries.push_back(Entry(EntityId(i * 2, 0), ComponentHandle(i, 0)));
+	}
+	SortedVector<Entry> plain;
+	plain.data = entries;
+	Map indexed;
+	indexed.insert_range(entries.begin(), entries.end());
+	entries = std::vector<Entry>();
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<size_t> roster(0, 2 * n - 1);
+	std::vector<EntityId> queries(1000000);
+	for (EntityId& q : queries) {
+		q = EntityId(roster(rng), 0);
+	}
+
+	size_t plain_found = 0;
+	size_t indexed_found = 0;
+	const double plain_lookup = timePerCall(queries.size(), [&](size_t i) {
+		plain_found += plain.lookup(queries[i]) != plain.data.end();
+	});
+	const double indexed_lookup = timePerCall(queries.size(), [&](size_t i) {
+		indexed_found += indexed.lookup(queries[i]) != indexed.data.end();
+	});
+	CHECK(plain_found == indexed_found);
+
+	// Removal also moves the tail of the array, which grows with n
+	const size_t num_removals = n >= 10000000 ? 20 : 1000;
+	std::vector<EntityId> removals(num_removals);
+	for (size_t i = 0; i < num_removals; ++i) {
+		removals[i] = EntityId(std::uniform_int_distribution<size_t>(0, n - 1)(rng) * 2, 0);
+	}
+	const double plain_remove = timePerCall(num_removals, [&](size_t i) {
+		plain.remove(removals[i]);
+	});
+	const double indexed_remove = timePerCall(num_removals, [&](size_t i) {
+		indexed.remove(removals[i]);
+	});
+	CHECK(plain.data == indexed.data);
+
+	std::printf("%9u entries: lookup %7.1f -> %6.1f ns (%.1fx), remove %10.1f -> %10.1f ns\n",
+		unsigned(n), plain_lookup, indexed_lookup, plain_lookup / indexed_lookup, plain_remove, indexed_remove);
+}
+
+int main() {
+	const size_t sizes[] = { 1000, 100000, 10000000 };
+	for (size_t n : sizes) {
+		benchmark(n);
+	}
+	return 0;
+}
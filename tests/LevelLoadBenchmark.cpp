@@ -0,0 +1,75 @@
+// Loads and unloads a level of 100K entities' worth of pools and maps, once
+// from the heap and once carved from a single arena. Build and run from the
+// repository root:
+//   g++ -std=c++11 -O2 -Isrc -Ilibyuriks tests/LevelLoadBenchmark.cpp libyuriks/memory/FrameArena.cpp libyuriks/memory/MemoryResource.cpp -o LevelLoadBenchmark && ./LevelLoadBenchmark
+#include "memory/FrameArena.hpp"
+#include "memory/MemoryResource.hpp"
+#include "memory/ObjectPool.hpp"
+#include "SortedVector.hpp"
+#include "Handle.hpp"
+#include "check.hpp"
+#include <chrono>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+using namespace yks;
+
+struct Position {
+	float x, y;
+	Position(float x, float y) : x(x), y(y) {}
+};
+
+typedef std::tuple<Handle, Handle> MapEntry;
+typedef SortedVector<MapEntry, TupleKey<MapEntry>, ResourceVector<MapEntry>> Map;
+
+static const int num_entities = 100000;
+static const int num_types = 8;
+static const int num_levels = 20;
+
+/** Fills a pool and a component map per type, then frees them all. Returns
+ * the sum of the positions so the work can't be optimized away. */
+static double loadLevel(MemoryResource* resource) {
+	std::vector<ObjectPool<Position, ResourceVector>> pools;
+	std::vector<Map> maps;
+	for (int type = 0; type < num_types; ++type) {
+		pools.emplace_back(resource);
+		maps.emplace_back(resource);
+		for (int i = 0; i < num_entities / num_types; ++i) {
+			const Handle h = pools.back().emplace(float(i), float(type));
+			maps.back().data.push_back(MapEntry(Handle(i, 0), h));
+		}
+	}
+
+	double sum = 0.0;
+	for (int type = 0; type < num_types; ++type) {
+		CHECK(maps[type].data.size() == pools[type].size());
+		for (const MapEntry& entry : maps[type].data) {
+			const Position* pos = pools[type][std::get<1>(entry)];
+			sum += pos->x + pos->y;
+		}
+	}
+	return sum;
+}
+
+static double timeLevels(const char* name, MemoryResource* resource, FrameArena* arena) {
+	double sum = 0.0;
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (int level = 0; level < num_levels; ++level) {
+		sum += loadLevel(resource);
+		if (arena != nullptr) {
+			arena->reset();
+		}
+	}
+	const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+	std::printf("%-6s %8.1f us per level\n", name, double(us) / num_levels);
+	return sum;
+}
+
+int main() {
+	FrameArena level_arena(16 * 1024 * 1024);
+	const double heap_sum = timeLevels("heap", nullptr, nullptr);
+	const double arena_sum = timeLevels("arena", &level_arena, &level_arena);
+	CHECK(heap_sum == arena_sum);
+	return 0;
+}
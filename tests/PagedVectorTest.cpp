@@ -0,0 +1,124 @@
+// Tests for PagedVector as ObjectPool storage. Build and run from the repository root:
+//   g++ -std=c++11 -pthread -Isrc -Ilibyuriks tests/PagedVectorTest.cpp src/EntitySystem.cpp src/TimerWheel.cpp libyuriks/ThreadPool.cpp libyuriks/memory/FrameArena.cpp libyuriks/memory/MemoryResource.cpp -o PagedVectorTest && ./PagedVectorTest
+#include "EntityQuery.hpp"
+#include "GameComponents.hpp"
+#include "memory/FrameArena.hpp"
+#include "memory/ObjectPool.hpp"
+#include "memory/PagedVector.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace yks;
+
+static void testPointersStayValid() {
+	ObjectPool<std::string, PagedVector> pool;
+	std::vector<Handle> handles;
+	std::vector<const std::string*> pointers;
+	for (int i = 0; i < 10000; ++i) {
+		handles.push_back(pool.emplace(std::to_string(i)));
+		pointers.push_back(pool[handles.back()]);
+	}
+	CHECK(pool.pool.capacity() % PagedVector<std::string>::elements_per_page == 0);
+	for (int i = 0; i < 10000; ++i) {
+		CHECK(pool[handles[i]] == pointers[i]);
+		CHECK(*pointers[i] == std::to_string(i));
+	}
+
+	// Swap-removing moves the last object into the hole, and leaves the rest in place
+	for (int i = 0; i < 10000; i += 3) {
+		pool.remove(handles[i]);
+	}
+	CHECK(pool.size() == 10000 - 3334);
+	size_t visited = 0;
+	for (auto entry : pool) {
+		CHECK(entry.second == std::to_string(entry.first.index));
+		++visited;
+	}
+	CHECK(visited == pool.size());
+}
+
+static void testTombstonesAndBulkInsert() {
+	ObjectPool<uint64_t, PagedVector> pool;
+	pool.setRemovalPolicy(RemovalPolicy::tombstone);
+	std::vector<Handle> handles(5000);
+	const size_t first = pool.emplace_n(handles.size(), 7, handles.data());
+	CHECK(first == 0);
+	for (size_t i = 0; i < handles.size(); ++i) {
+		*pool[handles[i]] = i;
+	}
+
+	std::vector<Handle> victims;
+	for (size_t i = 0; i < handles.size(); i += 2) {
+		victims.push_back(handles[i]);
+	}
+	pool.remove_many(victims.data(), victims.size());
+	CHECK(pool.size() == 2500);
+	CHECK(pool.pool.size() == 2500);
+	for (size_t i = 1; i < handles.size(); i += 2) {
+		CHECK(*pool[handles[i]] == i);
+		CHECK(pool.getPoolIndex(handles[i]) == i / 2);
+	}
+}
+
+struct Aligned {
+	static const ComponentTypeId component_id = 5;
+
+	alignas(64) float values[16];
+
+	explicit Aligned(float v) {
+		for (float& x : values) {
+			x = v;
+		}
+	}
+};
+
+static void testAlignment() {
+	ObjectPool<Aligned, PagedVector> pool;
+	for (int i = 0; i < 1000; ++i) {
+		const Handle h = pool.emplace(float(i));
+		CHECK(reinterpret_cast<uintptr_t>(pool[h]) % 64 == 0);
+	}
+
+	FrameArena arena;
+	ObjectPool<Aligned, PagedVector> arena_pool(&arena);
+	for (int i = 0; i < 1000; ++i) {
+		const Handle h = arena_pool.emplace(float(i));
+		CHECK(reinterpret_cast<uintptr_t>(arena_pool[h]) % 64 == 0);
+		CHECK(arena_pool[h]->values[15] == float(i));
+	}
+}
+
+static void testQuery() {
+	EntityWorld world;
+	world.addComponentType(Position::component_id, "Position");
+	world.addComponentType(Aligned::component_id, "Aligned");
+	ObjectPool<Position, PagedVector> positions;
+	ObjectPool<Aligned, PagedVector> aligned;
+
+	for (int i = 0; i < 3000; ++i) {
+		const EntityId e = world.createEntity("test");
+		world.addComponentToEntity(positions, e, yks::vec2{{ float(i), 0.0f }});
+		if (i % 2 == 0) {
+			world.addComponentToEntity(aligned, e, float(i));
+		}
+	}
+
+	size_t visited = 0;
+	query_for_each(world, std::tie(positions, aligned), [&](Position& pos, Aligned& a) {
+		CHECK(pos.position[0] == a.values[0]);
+		++visited;
+	});
+	CHECK(visited == 1500);
+}
+
+int main() {
+	testPointersStayValid();
+	testTombstonesAndBulkInsert();
+	testAlignment();
+	testQuery();
+	std::puts("PagedVectorTest passed");
+	return 0;
+}
@@ -0,0 +1,128 @@
+// Randomized test of SpatialHash against brute force, driven through GameWorld
+// updates. Build and run from the repository root:
+//   g++ -std=c++11 -O2 -pthread -Isrc -Ilibyuriks tests/SpatialHashTest.cpp src/GameWorld.cpp src/EntitySystem.cpp src/SpatialHash.cpp src/Collision.cpp src/TimerWheel.cpp libyuriks/ThreadPool.cpp libyuriks/memory/FrameArena.cpp libyuriks/memory/MemoryStats.cpp libyuriks/memory/MemoryResource.cpp -o SpatialHashTest && ./SpatialHashTest
+#include "GameWorld.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const float world_extent = 2000.0f;
+
+static std::vector<size_t> bruteForceQuery(GameWorld& game, yks::vec2 center, float radius) {
+	std::vector<size_t> found;
+	for (const auto& row : game.world.components_by_component_type[Position::component_id].data) {
+		const EntityId entity = std::get<0>(row);
+		const Position* pos = game.positionPool[std::get<1>(row)];
+		if (pos == nullptr || !game.world.isEntityEnabled(entity))
+			continue;
+		const float dx = pos->position[0] - center[0];
+		const float dy = pos->position[1] - center[1];
+		if (dx * dx + dy * dy <= radius * radius) {
+			found.push_back(entity.index);
+		}
+	}
+	std::sort(found.begin(), found.end());
+	return found;
+}
+
+static void checkAgainstBruteForce(GameWorld& game) {
+	const SpatialHash& hash = game.spatial_hash;
+
+	size_t live = 0;
+	for (const auto& row : game.world.components_by_component_type[Position::component_id].data) {
+		const EntityId entity = std::get<0>(row);
+		const bool indexed = game.positionPool[std::get<1>(row)] != nullptr && game.world.isEntityEnabled(entity);
+		CHECK(hash.contains(entity) == indexed);
+		live += indexed;
+	}
+	CHECK(hash.size() == live);
+
+	std::vector<EntityId> out;
+	for (int q = 0; q < 50; ++q) {
+		const yks::vec2 center = {{ randRange(game.rng, -world_extent, world_extent), randRange(game.rng, -world_extent, world_extent) }};
+		const float radius = randRange(game.rng, 1.0f, q % 20 == 0 ? 3000.0f : 300.0f);
+
+		out.clear();
+		hash.queryRadius(center, radius, out);
+		std::vector<size_t> found;
+		for (EntityId e : out) {
+			found.push_back(e.index);
+		}
+		std::sort(found.begin(), found.end());
+		CHECK(std::adjacent_find(found.begin(), found.end()) == found.end());
+		CHECK(found == bruteForceQuery(game, center, radius));
+	}
+}
+
+/** Runs frames that spawn, destroy, disable, strip and teleport entities.
+ * Slow entities mostly stay in their bucket, so the hash merges the few
+ * that moved; fast ones make it sort everything again. */
+static void testRandomFrames(float max_speed) {
+	GameWorld game(3);
+	std::vector<EntityId> ids;
+	auto spawn = [&] {
+		const EntityId e = game.world.createEntity("test");
+		game.world.addComponentToEntity(game.positionPool, e, yks::vec2{{ randRange(game.rng, -world_extent, world_extent), randRange(game.rng, -world_extent, world_extent) }});
+		game.world.addComponentToEntity(game.velocityPool, e, yks::vec2{{ randRange(game.rng, -max_speed, max_speed), randRange(game.rng, -max_speed, max_speed) }});
+		ids.push_back(e);
+	};
+	auto randomEntity = [&] {
+		return static_cast<size_t>(randRange(game.rng, 0, static_cast<int>(ids.size()) - 1));
+	};
+
+	for (int i = 0; i < 40000; ++i) {
+		spawn();
+	}
+	for (int frame = 0; frame < 300; ++frame) {
+		switch (frame % 6) {
+		case 1:
+			for (int k = 0; k < 50; ++k) {
+				const EntityId e = ids[randomEntity()];
+				game.world.setEntityEnabled(e, !game.world.isEntityEnabled(e));
+			}
+			break;
+		case 2:
+			for (int k = 0; k < 30; ++k) {
+				const size_t i = randomEntity();
+				game.world.destroyEntity(ids[i]);
+				ids.erase(ids.begin() + i);
+			}
+			break;
+		case 3:
+			for (int k = 0; k < 40; ++k) {
+				spawn();
+			}
+			break;
+		case 4:
+			for (int k = 0; k < 20; ++k) {
+				const EntityId e = ids[randomEntity()];
+				const ComponentHandle pos = game.world.findComponent(e, Position::component_id);
+				if (pos != ComponentHandle()) {
+					game.world.removeComponentFromEntity(e, Position::component_id);
+					game.positionPool.remove(pos);
+				}
+			}
+			break;
+		case 5:
+			for (int k = 0; k < 10; ++k) {
+				game.spatial_hash.move(ids[randomEntity()], yks::vec2{{ 0.0f, 0.0f }});
+			}
+			break;
+		}
+
+		game.update();
+		if (frame % 5 == 0) {
+			checkAgainstBruteForce(game);
+		}
+	}
+	checkAgainstBruteForce(game);
+}
+
+int main() {
+	testRandomFrames(0.3f);
+	testRandomFrames(2.0f);
+	testRandomFrames(20.0f);
+	std::puts("SpatialHashTest passed");
+	return 0;
+}
@@ -0,0 +1,90 @@
+// Standalone test for TimerWheel. Build and run from the repository root:
+//   g++ -std=c++11 -Isrc -Ilibyuriks tests/TimerWheelTest.cpp src/TimerWheel.cpp -o TimerWheelTest && ./TimerWheelTest
+#include "TimerWheel.hpp"
+#include "check.hpp"
+#include <cstdio>
+#include <vector>
+
+static void testFiresInOrderOfExpiry() {
+	TimerWheel wheel;
+	std::vector<TimerEventId> fired;
+	wheel.schedule(yks::Handle(), 3, 3);
+	wheel.schedule(yks::Handle(), 1, 1);
+	wheel.schedule(yks::Handle(), 500, 500);
+
+	for (int i = 0; i < 500; ++i) {
+		wheel.advance([&](yks::Handle, TimerEventId event) { fired.push_back(event); });
+	}
+	CHECK(fired.size() == 3);
+	CHECK(fired[0] == 1 && fired[1] == 3 && fired[2] == 500);
+}
+
+static void testCancelFromCallback() {
+	TimerWheel wheel;
+	const TimerId first = wheel.schedule(yks::Handle(), 1, 5);
+	const TimerId second = wheel.schedule(yks::Handle(), 2, 5);
+	const TimerId third = wheel.schedule(yks::Handle(), 3, 5);
+
+	std::vector<TimerEventId> fired;
+	for (int i = 0; i < 5; ++i) {
+		wheel.advance([&](yks::Handle, TimerEventId event) {
+			fired.push_back(event);
+			// Whichever fires first cancels the other two
+			wheel.cancel(first);
+			wheel.cancel(second);
+			wheel.cancel(third);
+		});
+	}
+	CHECK(fired.size() == 1);
+	CHECK(!wheel.isPending(first) && !wheel.isPending(second) && !wheel.isPending(third));
+}
+
+static void testScheduleFromCallback() {
+	TimerWheel wheel;
+	wheel.schedule(yks::Handle(), 1, 1);
+
+	std::vector<TimerEventId> fired;
+	for (int i = 0; i < 3; ++i) {
+		wheel.advance([&](yks::Handle, TimerEventId event) {
+			fired.push_back(event);
+			if (event == 1) {
+				wheel.schedule(yks::Handle(), 2, 0);
+			}
+		});
+	}
+	CHECK(fired.size() == 2);
+	CHECK(fired[1] == 2);
+}
+
+static void testCancelOwner() {
+	TimerWheel wheel;
+	const yks::Handle a(3, 0), b(3, 1), c(4, 0);
+	wheel.schedule(a, 1, 2);
+	wheel.schedule(b, 2, 2);
+	wheel.schedule(a, 3, 100);
+	wheel.schedule(c, 4, 2);
+	wheel.schedule(a, 5, 2);
+
+	wheel.cancelOwner(a);
+
+	std::vector<TimerEventId> fired;
+	for (int i = 0; i < 100; ++i) {
+		wheel.advance([&](yks::Handle, TimerEventId event) {
+			fired.push_back(event);
+			// Whichever fires first cancels the other's timer in the same slot
+			wheel.cancelOwner(b);
+			wheel.cancelOwner(c);
+		});
+	}
+	CHECK(fired.size() == 1);
+	CHECK(fired[0] == 2 || fired[0] == 4);
+}
+
+int main() {
+	testFiresInOrderOfExpiry();
+	testCancelFromCallback();
+	testScheduleFromCallback();
+	testCancelOwner();
+	std::puts("TimerWheelTest passed");
+	return 0;
+}
@@ -0,0 +1,149 @@
+// Tests for WorldDeltaEncoder. Build and run from the repository root:
+//   g++ -std=c++11 -pthread -Isrc -Ilibyuriks tests/WorldDeltaTest.cpp src/WorldDelta.cpp src/EntitySystem.cpp src/TimerWheel.cpp libyuriks/ThreadPool.cpp libyuriks/memory/FrameArena.cpp libyuriks/memory/MemoryResource.cpp -o WorldDeltaTest && ./WorldDeltaTest
+#include "WorldDelta.hpp"
+#include "GameComponents.hpp"
+#include "memory/PagedVector.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+struct TestWorld {
+	EntityWorld world;
+	yks::ObjectPool<Position> positions;
+	yks::ObjectPool<Velocity, yks::PagedVector> velocities; // Any pool Storage can be registered
+	WorldDeltaEncoder encoder;
+
+	TestWorld() {
+		world.addComponentType(Position::component_id, "Position");
+		world.addComponentType(Velocity::component_id, "Velocity");
+		encoder.addPool(positions);
+		encoder.addPool(velocities);
+	}
+
+	EntityId spawn(float x) {
+		const EntityId e = world.createEntity("test");
+		world.addComponentToEntity(positions, e, yks::vec2{{ x, 0.0f }});
+		world.addComponentToEntity(velocities, e, yks::vec2{{ 1.0f, 0.0f }});
+		return e;
+	}
+};
+
+static bool sameSnapshot(const WorldSnapshot& a, const WorldSnapshot& b) {
+	if (a.entities != b.entities || a.disabled != b.disabled || a.components.size() != b.components.size())
+		return false;
+	for (size_t i = 0; i < a.components.size(); ++i) {
+		const WorldSnapshot::ComponentRecord& x = a.components[i];
+		const WorldSnapshot::ComponentRecord& y = b.components[i];
+		if (x.entity != y.entity || x.type != y.type || x.size != y.size)
+			return false;
+		if (std::memcmp(a.data.data() + x.offset, b.data.data() + y.offset, x.size) != 0)
+			return false;
+	}
+	return true;
+}
+
+/** Steps a world through spawning, moving, parking and destroying
+ * entities, checking that each frame's delta rebuilds its snapshot. */
+static void testRoundTrip() {
+	TestWorld w;
+	std::vector<EntityId> ids;
+	for (int i = 0; i < 100; ++i) {
+		ids.push_back(w.spawn(float(i)));
+	}
+
+	WorldSnapshot prev;
+	w.encoder.takeSnapshot(w.world, prev);
+	for (int frame = 0; frame < 20; ++frame) {
+		for (int i = frame; i < 100; i += 7) {
+			w.positions[w.world.findComponent(ids[i], Position::component_id)]->position[1] += 1.0f;
+		}
+		// Despawning parks projectiles by disabling them, which the replay has to show
+		w.world.setEntityEnabled(ids[frame], false);
+		if (frame >= 5) {
+			w.world.setEntityEnabled(ids[frame - 5], true);
+		}
+		if (frame % 3 == 0) {
+			w.world.destroyEntity(ids[99 - frame]);
+			ids[99 - frame] = w.spawn(-float(frame));
+			w.world.setEntityEnabled(ids[99 - frame], false);
+		}
+		if (frame % 4 == 0) {
+			const EntityId e = ids[50 + frame];
+			const ComponentHandle v = w.world.findComponent(e, Velocity::component_id);
+			w.world.removeComponentFromEntity(e, Velocity::component_id);
+			w.velocities.remove(v);
+		}
+
+		WorldSnapshot next;
+		w.encoder.takeSnapshot(w.world, next);
+		CHECK(next.disabled.size() == std::min(frame + 1, 5) + (frame / 3 + 1));
+
+		std::vector<uint8_t> delta;
+		WorldDeltaEncoder::encodeDelta(prev, next, delta);
+		WorldSnapshot rebuilt;
+		CHECK(WorldDeltaEncoder::applyDelta(prev, delta.data(), delta.size(), rebuilt));
+		CHECK(sameSnapshot(rebuilt, next));
+
+		prev = next;
+	}
+}
+
+/** Deltas cut short or corrupted must be rejected or decoded without
+ * reading past the end, never crash. */
+static void testMalformedDeltas() {
+	TestWorld w;
+	std::vector<EntityId> ids;
+	for (int i = 0; i < 20; ++i) {
+		ids.push_back(w.spawn(float(i)));
+	}
+	WorldSnapshot from;
+	w.encoder.takeSnapshot(w.world, from);
+
+	w.world.destroyEntity(ids[3]);
+	w.world.setEntityEnabled(ids[4], false);
+	w.spawn(100.0f);
+	w.positions[w.world.findComponent(ids[5], Position::component_id)]->position[0] = 42.0f;
+	WorldSnapshot to;
+	w.encoder.takeSnapshot(w.world, to);
+
+	std::vector<uint8_t> delta;
+	WorldDeltaEncoder::encodeDelta(from, to, delta);
+	WorldSnapshot rebuilt;
+	CHECK(WorldDeltaEncoder::applyDelta(from, delta.data(), delta.size(), rebuilt));
+	CHECK(sameSnapshot(rebuilt, to));
+
+	// Every section is always written, so no strict prefix is a whole delta
+	for (size_t n = 0; n < delta.size(); ++n) {
+		const std::vector<uint8_t> truncated(delta.begin(), delta.begin() + n);
+		CHECK(!WorldDeltaEncoder::applyDelta(from, truncated.data(), truncated.size(), rebuilt));
+	}
+
+	std::mt19937 rng(1234);
+	for (int i = 0; i < 10000; ++i) {
+		std::vector<uint8_t> corrupted = delta;
+		corrupted[rng() % corrupted.size()] ^= static_cast<uint8_t>(1 + rng() % 255);
+		WorldDeltaEncoder::applyDelta(from, corrupted.data(), corrupted.size(), rebuilt);
+	}
+
+	// Disabling an entity twice, or one that doesn't exist, is malformed
+	std::vector<uint8_t> twice;
+	WorldSnapshot none_disabled = to;
+	none_disabled.disabled.clear();
+	WorldDeltaEncoder::encodeDelta(none_disabled, to, twice);
+	CHECK(!WorldDeltaEncoder::applyDelta(to, twice.data(), twice.size(), rebuilt));
+	CHECK(WorldDeltaEncoder::applyDelta(none_disabled, twice.data(), twice.size(), rebuilt));
+	CHECK(sameSnapshot(rebuilt, to));
+
+	WorldSnapshot empty;
+	CHECK(!WorldDeltaEncoder::applyDelta(empty, twice.data(), twice.size(), rebuilt));
+}
+
+int main() {
+	testRoundTrip();
+	testMalformedDeltas();
+	std::puts("WorldDeltaTest passed");
+	return 0;
+}
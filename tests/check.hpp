@@ -0,0 +1,6 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// Like assert, but also checked in release builds.
+#define CHECK(cond) do { if (!(cond)) { std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); std::abort(); } } while (0)